@@ -37,6 +37,7 @@
 #include <iostream>
 #include <fstream>
 #include <cstdlib>
+#include <cctype>
 #include <algorithm>
 #include <sstream>
 #include <vector>
@@ -165,6 +166,26 @@ static void* callback_thread(const std::string& gameName){
 
     return NULL;
 }
+
+static void fastForwardLoop(int maxFrames) {
+    LOGI("Fast-forward mode, frame count: " << maxFrames);
+
+    const float startTime = TimeUtil::GetTime();
+    float worstFrame = 0;
+    int frames = 0;
+    while (!game->isFinished && (maxFrames <= 0 || frames < maxFrames)) {
+        const float t = TimeUtil::GetTime();
+        game->step();
+        worstFrame = glm::max(worstFrame, TimeUtil::GetTime() - t);
+        frames++;
+    }
+
+    const float dt = TimeUtil::GetTime() - startTime;
+    std::cout << frames << " frames (" << frames * game->targetDT << " sec of game time) in "
+        << dt << " sec. Avg: " << (frames ? (1000 * dt) / frames : 0)
+        << " ms/frame, worst: " << 1000 * worstFrame << " ms/frame\n";
+    game->frameStats.report(std::cout);
+}
 #endif
 
 static void addWindowIcon(SDL_Window* window);
@@ -179,7 +200,11 @@ struct CommandLineOptions {
         verbose = 0;
         forceEtc1 = false;
         headless = false;
+        fastForward = false;
+        frameCount = 0;
+        pipelined = false;
         profiler = false;
+        frameStats = NULL;
 #if SAC_NETWORK
         nickname = NULL;
         lobby = NULL;
@@ -189,7 +214,14 @@ struct CommandLineOptions {
     int verbose;
     bool forceEtc1;
     bool headless;
+    // no window: simulate back-to-back steps, then exit
+    bool fastForward;
+    // fast-forward frame count (0: until the game finishes)
+    int frameCount;
+    bool pipelined;
     bool profiler;
+    // file frame time histograms are written to, at exit
+    const char* frameStats;
 #if SAC_NETWORK
     const char* nickname;
     const char* lobby;
@@ -202,21 +234,41 @@ int setupEngine(void* _game, const SetupInfo* info) {
         initLogColors();
     #endif
 
+#if SAC_EMSCRIPTEN
+    const char* script = ""\
+        "var r = localStorage.getItem(\"sac_root\");" \
+        "if (r != null) { Module.print('Restoring root');"\
+        "   FS.root.contents['sac_temp'] = window.JSON.parse(r); Module.print('Restoring nextItem');"\
+        "   FS.nextInode = window.JSON.parse(localStorage.getItem(\"sac_nextItem\"));"\
+        " } else { "\
+        "Module['FS_createFolder']('/', 'sac_temp', true, true);" \
+        "}";
+    emscripten_run_script(script);
+    CommandLineOptions options;
+#else
+    auto options =
+        parseCommandLineOption(info->arg.c, info->arg.v);
+#endif
+
     /////////////////////////////////////////////////////
     // Init Window and Rendering
-    if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO) < 0) {
+    if (SDL_Init(options.fastForward ? 0 : (SDL_INIT_VIDEO | SDL_INIT_AUDIO)) < 0) {
         return 1;
     }
 
-    if ((sdlWindow = SDL_CreateWindow(info->name, SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
-        640, 480, SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE )) == 0) {
-        LOGE("SDL create window failed: " << SDL_GetError());
-        return 1;
-    }
+    if (!options.fastForward) {
+        if ((sdlWindow = SDL_CreateWindow(info->name, SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
+            640, 480, SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE )) == 0) {
+            LOGE("SDL create window failed: " << SDL_GetError());
+            return 1;
+        }
 
-    addWindowIcon(sdlWindow);
+        addWindowIcon(sdlWindow);
+    }
 
     game = static_cast<Game*> (_game);
+    game->fastForward = options.fastForward;
+    theRenderingSystem.headless = options.fastForward;
 
 #if SAC_DESKTOP
     game->arg.c = info->arg.c;
@@ -231,21 +283,6 @@ int setupEngine(void* _game, const SetupInfo* info) {
     uint8_t* state = 0;
     int size = 0;
 
-#if SAC_EMSCRIPTEN
-    const char* script = ""\
-        "var r = localStorage.getItem(\"sac_root\");" \
-        "if (r != null) { Module.print('Restoring root');"\
-        "   FS.root.contents['sac_temp'] = window.JSON.parse(r); Module.print('Restoring nextItem');"\
-        "   FS.nextInode = window.JSON.parse(localStorage.getItem(\"sac_nextItem\"));"\
-        " } else { "\
-        "Module['FS_createFolder']('/', 'sac_temp', true, true);" \
-        "}";
-    emscripten_run_script(script);
-    CommandLineOptions options;
-#else
-    auto options =
-        parseCommandLineOption(info->arg.c, info->arg.v);
-#endif
 
 
     int largestDimension = 1024;
@@ -254,7 +291,7 @@ int setupEngine(void* _game, const SetupInfo* info) {
         w2hRatio = 1.0f / w2hRatio;
     }
 
-    {
+    if (!options.fastForward) {
         SDL_DisplayMode mode;
         if (0 == SDL_GetCurrentDisplayMode(0, &mode)) {
             while (mode.w < largestDimension ||
@@ -265,15 +302,21 @@ int setupEngine(void* _game, const SetupInfo* info) {
     }
     glm::vec2 resolution (largestDimension, largestDimension * w2hRatio);
 
-    SDL_SetWindowSize(sdlWindow, resolution.x, resolution.y);
-    SDL_GLContext sdlContext;
-    if  ((sdlContext = SDL_GL_CreateContext(sdlWindow)) == 0) {
-        LOGE("SDL create context failed: " << SDL_GetError());
-        return 1;
+    SDL_GLContext sdlContext = 0;
+    if (!options.fastForward) {
+        SDL_SetWindowSize(sdlWindow, resolution.x, resolution.y);
+        if  ((sdlContext = SDL_GL_CreateContext(sdlWindow)) == 0) {
+            LOGE("SDL create context failed: " << SDL_GetError());
+            return 1;
+        }
+        // swaps wait for vertical sync: it paces the render thread, which
+        // otherwise waits for the game thread (see RenderingSystem::render)
+        if (SDL_GL_SetSwapInterval(1) != 0)
+            LOGW("Unable to enable vsync: " << SDL_GetError());
     }
 
 #if !SAC_EMSCRIPTEN
-    if (glewInit() != GLEW_OK)
+    if (!options.fastForward && glewInit() != GLEW_OK)
         return 1;
 
     if (options.restore) {
@@ -395,7 +438,8 @@ int setupEngine(void* _game, const SetupInfo* info) {
     }
     #endif
 
-    if (!options.headless)
+    theRenderingSystem.pipelined = options.pipelined;
+    if (!options.headless && !options.fastForward)
         theRenderingSystem.enableRendering();
 
     LOGV(1, "Run game loop");
@@ -410,33 +454,37 @@ int setupEngine(void* _game, const SetupInfo* info) {
             startProfiler();
     #endif
 
-    SDL_JoystickEventState(SDL_ENABLE);
-
     //used for text translation, if needed
     setlocale( LC_ALL, "" );
     setlocale( LC_NUMERIC, "C" );
 
-    std::unique_lock<std::mutex> lock(m);
-    std::thread th1(callback_thread, info->name);
-    cond.wait(lock);
-    lock.unlock();
-
-    float prevT = 0;
+    if (options.fastForward) {
+        fastForwardLoop(options.frameCount);
+    } else {
+        SDL_JoystickEventState(SDL_ENABLE);
 
-    do {
-        game->eventsHandler();
-        if (!options.headless) {
-            game->render();
-            SDL_GL_SwapWindow(sdlWindow);
-            float t = TimeUtil::GetTime();
+        std::unique_lock<std::mutex> lock(m);
+        std::thread th1(callback_thread, info->name);
+        cond.wait(lock);
+        lock.unlock();
+
+        float prevT = 0;
+
+        do {
+            game->eventsHandler();
+            if (!options.headless) {
+                game->render();
+                SDL_GL_SwapWindow(sdlWindow);
+                float t = TimeUtil::GetTime();
 #if ! SAC_WINDOWS
-            Recorder::Instance().record(t - prevT);
+                Recorder::Instance().record(t - prevT);
 #endif
-            prevT = t;
-        }
-    } while (!game->isFinished); //!m.try_lock());
+                prevT = t;
+            }
+        } while (!game->isFinished); //!m.try_lock());
 
-    th1.join();
+        th1.join();
+    }
 
     LOGT("We should destroy API to let them uninit stuff "
         "(JoystickManager, MusicAPILinuxOpenALImplOpenAL, ...) + fix memory leaks");
@@ -449,11 +497,16 @@ int setupEngine(void* _game, const SetupInfo* info) {
     delete[] game->arg.v;
 #endif
 #endif
+    if (options.frameStats) {
+        game->frameStats.dump(options.frameStats);
+    }
     game->preDestroy();
     delete game;
  //   delete record;
-    SDL_GL_DeleteContext(sdlContext);
-    SDL_DestroyWindow(sdlWindow);
+    if (sdlWindow) {
+        SDL_GL_DeleteContext(sdlContext);
+        SDL_DestroyWindow(sdlWindow);
+    }
     SDL_Quit();
 
     return 0;
@@ -542,8 +595,21 @@ static CommandLineOptions parseCommandLineOption(int argc, char** argv) {
         options.verbose |= !strcmp(argv[i], "-v");
         options.verbose |= !strcmp(argv[i], "--verbose");
         options.headless |= !strcmp(argv[i], "--headless");
+        if (!strcmp(argv[i], "--fast-forward")) {
+            options.fastForward = true;
+            // optional frame count
+            if ((i+1) < argc && std::isdigit(argv[i+1][0])) {
+                options.frameCount = std::atoi(argv[i+1]);
+                i++;
+            }
+        }
         options.forceEtc1 |= !strcmp(argv[i], "--force-etc1");
+        options.pipelined |= !strcmp(argv[i], "--pipelined");
         options.profiler |= !strcmp("-profile", argv[i]);
+        if (!strcmp(argv[i], "--frame-stats")) {
+            LOGF_IF((i+1)>= argc, "Invalid argument count. Expecting a file name");
+            options.frameStats = argv[++i];
+        }
     #if SAC_INGAME_EDITORS
         if (!strcmp(argv[i], "--debug-area-width") ||
             !strcmp(argv[i], "-d-a-w")) {
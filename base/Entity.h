@@ -23,3 +23,28 @@
 #include <cstdint>
 #include <base/SacDefs.h>
 typedef uint32_t Entity;
+
+// An Entity handle packs a slot index (low bits) and the generation of this
+// slot (high bits). Slots are recycled with a new generation, so a handle
+// kept after its entity deletion doesn't alias the entity reusing the slot.
+namespace EntityHandle {
+    const unsigned IndexBits = 24;
+    const uint32_t IndexMask = (1u << IndexBits) - 1;
+    const uint32_t GenerationCount = 1u << (32 - IndexBits);
+
+    inline uint32_t index(Entity e) { return e & IndexMask; }
+    inline uint32_t generation(Entity e) { return e >> IndexBits; }
+    inline Entity make(uint32_t index, uint32_t generation) {
+        return (generation << IndexBits) | index;
+    }
+}
+
+// One bit per registered ComponentSystem (see ComponentSystem::getSignature)
+typedef uint64_t ComponentSignature;
+
+namespace EntityType {
+    enum Enum {
+        Volatile,
+        Persistent
+    };
+}
@@ -0,0 +1,140 @@
+/*
+    This file is part of Soupe Au Caillou.
+
+    @author Soupe au Caillou - Jordane Pelloux-Prayer
+    @author Soupe au Caillou - Gautier Pelloux-Prayer
+    @author Soupe au Caillou - Pierre-Eric Pelloux-Prayer
+
+    Soupe Au Caillou is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3.
+
+    Soupe Au Caillou is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Soupe Au Caillou.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "EntityCommandBuffer.h"
+#include "EntityManager.h"
+#include "base/FrameArena.h"
+#include "base/Log.h"
+#include "systems/System.h"
+
+#include <algorithm>
+
+EntityCommandBuffer::EntityCommandBuffer() : gameThread(std::thread::id()) {}
+
+Entity EntityCommandBuffer::CreateEntity(const hash_t id, EntityType::Enum type, EntityTemplateRef tmpl) {
+    const std::thread::id game = gameThread.load();
+    LOGF_IF(game != std::thread::id() && game != std::this_thread::get_id(),
+        "Deferred entity creation must happen on the game thread");
+    Entity e = theEntityManager.CreateEntity(id, type);
+    if (tmpl != InvalidEntityTemplateRef) {
+        std::lock_guard<std::mutex> lock(mutex);
+        recording.templates.push_back(std::make_pair(e, tmpl));
+    }
+    return e;
+}
+
+void EntityCommandBuffer::DeleteEntity(Entity e) {
+    std::lock_guard<std::mutex> lock(mutex);
+    recording.deletes.push_back(e);
+}
+
+void EntityCommandBuffer::AddComponent(Entity e, ComponentSystem* system) {
+    std::lock_guard<std::mutex> lock(mutex);
+    recording.adds.push_back(ComponentCommand { system, e });
+}
+
+void EntityCommandBuffer::RemoveComponent(Entity e, ComponentSystem* system) {
+    std::lock_guard<std::mutex> lock(mutex);
+    recording.removes.push_back(ComponentCommand { system, e });
+}
+
+bool EntityCommandBuffer::empty() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return recording.empty();
+}
+
+bool EntityCommandBuffer::Commands::empty() const {
+    return templates.empty() && adds.empty() && removes.empty() && deletes.empty();
+}
+
+void EntityCommandBuffer::Commands::clear() {
+    templates.clear();
+    adds.clear();
+    removes.clear();
+    deletes.clear();
+}
+
+void EntityCommandBuffer::flush() {
+    gameThread.store(std::this_thread::get_id());
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (recording.empty())
+            return;
+        std::swap(recording, applying);
+    }
+    auto& t = applying.templates;
+    auto& a = applying.adds;
+    auto& r = applying.removes;
+    auto& d = applying.deletes;
+
+    for (const auto& p: t) {
+        if (theEntityManager.isAlive(p.first))
+            theEntityManager.entityTemplateLibrary.applyEntityTemplate(p.first, p.second);
+    }
+
+    auto commandLess = [] (const ComponentCommand& c1, const ComponentCommand& c2) -> bool {
+        if (c1.system != c2.system)
+            return c1.system->getSignature() < c2.system->getSignature();
+        return EntityHandle::index(c1.e) < EntityHandle::index(c2.e);
+    };
+    auto commandEqual = [] (const ComponentCommand& c1, const ComponentCommand& c2) -> bool {
+        return c1.system == c2.system && c1.e == c2.e;
+    };
+
+    // one bulk add per system
+    std::sort(a.begin(), a.end(), commandLess);
+    a.erase(std::unique(a.begin(), a.end(), commandEqual), a.end());
+    FrameVector<Entity> batch;
+    batch.reserve(a.size());
+    for (unsigned i=0; i<a.size();) {
+        ComponentSystem* system = a[i].system;
+        batch.clear();
+        for (; i<a.size() && a[i].system == system; i++) {
+            const Entity e = a[i].e;
+            if (!theEntityManager.isAlive(e))
+                continue;
+            if (theEntityManager.hasComponents(e, system->getSignature())) {
+                LOGW("Deferred add of component '" << INV_HASH(system->getId()) << "' to entity '"
+                    << theEntityManager.entityName(e) << "' which already has one");
+                continue;
+            }
+            batch.push_back(e);
+        }
+        if (!batch.empty())
+            theEntityManager.AddComponentToEntities(batch.data(), batch.size(), { system });
+    }
+
+    std::sort(r.begin(), r.end(), commandLess);
+    r.erase(std::unique(r.begin(), r.end(), commandEqual), r.end());
+    for (const auto& c: r) {
+        if (theEntityManager.hasComponents(c.e, c.system->getSignature()))
+            theEntityManager.RemoveComponent(c.e, c.system);
+    }
+
+    std::sort(d.begin(), d.end());
+    d.erase(std::unique(d.begin(), d.end()), d.end());
+    d.erase(std::remove_if(d.begin(), d.end(), [] (Entity e) -> bool {
+        return !theEntityManager.isAlive(e);
+    }), d.end());
+    if (!d.empty())
+        theEntityManager.DeleteEntities(d.data(), d.size());
+
+    applying.clear();
+}
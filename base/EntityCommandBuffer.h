@@ -0,0 +1,81 @@
+/*
+    This file is part of Soupe Au Caillou.
+
+    @author Soupe au Caillou - Jordane Pelloux-Prayer
+    @author Soupe au Caillou - Gautier Pelloux-Prayer
+    @author Soupe au Caillou - Pierre-Eric Pelloux-Prayer
+
+    Soupe Au Caillou is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3.
+
+    Soupe Au Caillou is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Soupe Au Caillou.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "Entity.h"
+#include "systems/opengl/EntityTemplateLibrary.h"
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ComponentSystem;
+
+// Structural changes (create/delete entities, add/remove components)
+// recorded during systems update and applied later, in batch, by flush().
+// This keeps components storage stable while systems iterate on it.
+// DeleteEntity, AddComponent and RemoveComponent are thread safe. flush()
+// must be called from the game thread, when no system runs.
+class EntityCommandBuffer {
+    public:
+        EntityCommandBuffer();
+
+        // The entity is created right away (so its handle can be used to
+        // record more commands) but without any component: its template
+        // is applied on flush.
+        // Not thread safe: this modifies EntityManager's tables, so it must
+        // be called from the game thread, by a system updated alone (i.e.
+        // not declaring its accesses, see ComponentSystem::declareAccesses).
+        Entity CreateEntity(const hash_t id, EntityType::Enum type = EntityType::Volatile,
+            EntityTemplateRef tmpl = InvalidEntityTemplateRef);
+        void DeleteEntity(Entity e);
+        void AddComponent(Entity e, ComponentSystem* system);
+        void RemoveComponent(Entity e, ComponentSystem* system);
+
+        // Applies recorded commands: templates, then component additions
+        // and removals (grouped by system), then deletions.
+        // Commands targetting an entity deleted meanwhile are dropped.
+        void flush();
+
+        bool empty() const;
+
+    private:
+        struct ComponentCommand {
+            ComponentSystem* system;
+            Entity e;
+        };
+        struct Commands {
+            std::vector<std::pair<Entity, EntityTemplateRef> > templates;
+            std::vector<ComponentCommand> adds, removes;
+            std::vector<Entity> deletes;
+
+            bool empty() const;
+            // keeps capacity, so a steady flow of commands doesn't allocate
+            void clear();
+        };
+        mutable std::mutex mutex;
+        // commands are recorded in 'recording', which is swapped with
+        // 'applying' by flush (so recording during flush is possible)
+        Commands recording, applying;
+        // thread calling flush(), i.e. the game thread (unknown until then)
+        std::atomic<std::thread::id> gameThread;
+};
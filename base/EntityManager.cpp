@@ -25,6 +25,7 @@
 #include <cstring>
 #include "base/Log.h"
 #include "base/TimeUtil.h"
+#include "base/FrameArena.h"
 #include <algorithm>
 
 #if SAC_ANDROID || SAC_WINDOWS || SAC_DARWIN || SAC_IOS
@@ -39,19 +40,22 @@ throw()
 #endif
 
 EntityManager* EntityManager::instance = 0;
+const ComponentSignature EntityManager::AliveBit;
+const ComponentSignature EntityManager::PersistentBit;
+const ComponentSignature EntityManager::ReservedBits;
+
+// index of the lowest set bit (signature must not be 0)
+static inline unsigned lowestBit(ComponentSignature s) {
+#if SAC_WINDOWS
+    unsigned long idx;
+    _BitScanForward64(&idx, s);
+    return idx;
+#else
+    return __builtin_ctzll(s);
+#endif
+}
 
-EntityManager::EntityManager() : nextEntity(1) {
-    LOGT("audit if System::entityComponents is needed - could be replaced by: if (entities[e] & TransformationSystemBit)");
-    LOGT("audit if EntityManager::entityComponents is needed. Lot of duplicated info");
-    LOGT("audit if EntityManager::permanentEntities is still useful");
-    LOGT("CreateEntities(int N)");
-    LOGT("addComponentsToEntities(int N, system1, system2, null)");
-    LOGT("DeleteEntities(int N);");
-    LOGT("DeleteEntities(int N, system1, system2, null);");
-    LOGT("benchmark 0 emitter");
-    LOGT("benchmark 1 emitter 50, 200, 1000");
-    LOGT("benchmark 2 emitter 50, 200, 1000");
-    LOGT("benchmark 3 emitter 50, 200, 1000");
+EntityManager::EntityManager() : nextEntity(1), aliveEntityCount(0), autoCompactOccupancy(0), lastCompactedEnd(0) {
 }
 
 EntityManager* EntityManager::Instance() {
@@ -70,47 +74,101 @@ void EntityManager::DestroyInstance() {
 
 #if SAC_INGAME_EDITORS
 void EntityManager::renameEntity(Entity e, hash_t id) {
-    _entityHash[e] = id;
+    setName(EntityHandle::index(e), id);
 }
 #endif
 
 unsigned EntityManager::entityCount() const {
-    return entityComponents.size();
+    return aliveEntityCount;
 }
 
-Entity EntityManager::CreateEntity(const hash_t id, EntityType::Enum type, EntityTemplateRef tmpl) {
-    Entity e = 0;
+void EntityManager::setName(uint32_t index, hash_t id) {
+    const hash_t previous = _entityHash[index];
+    if (previous == id)
+        return;
+    if (previous) {
+        auto it = nameIndex.find(previous);
+        it->second.erase(index);
+        if (it->second.empty())
+            nameIndex.erase(it);
+    }
+    if (id) {
+        nameIndex[id].insert(index);
+    }
+    _entityHash[index] = id;
+}
+
+void EntityManager::ensureCapacity(uint32_t index) {
+    if (index >= _entityHash.size()) {
+        const size_t size = 2 * (glm::max(_entityHash.size(), (size_t)index) + 1);
+        _entityHash.resize(size);
+        entitySignatures.resize(size, 0);
+        // generations outlive deleteAllEntities
+        entityGenerations.resize(glm::max(size, entityGenerations.size()), 0);
+    }
+}
 
-    // Reuse id if possible
+Entity EntityManager::nextEntityId() {
+    // Reuse slot if possible
     if (recyclableEntities.empty()) {
-        e = nextEntity++;
-    } else {
-        e = recyclableEntities.front();
-        LOGV(2, "Reuse entity " << e);
-        recyclableEntities.pop_front();
+        LOGF_IF(nextEntity > EntityHandle::IndexMask, "Too many entities");
+        ensureCapacity(nextEntity);
+        const uint32_t i = nextEntity++;
+        return EntityHandle::make(i, entityGenerations[i]);
+    }
+
+    const uint32_t i = recyclableEntities.front();
+    recyclableEntities.pop_front();
+    const Entity e = EntityHandle::make(i, entityGenerations[i]);
+    LOGV(2, "Reuse entity slot " << i << " as " << e);
 #if SAC_DEBUG
-        entityDeletionTime.erase(e);
+    // previous user of this slot
+    entityDeletionTime.erase(EntityHandle::make(i,
+        (entityGenerations[i] + EntityHandle::GenerationCount - 1) % EntityHandle::GenerationCount));
 #endif
-    }
+    return e;
+}
+
+void EntityManager::recycle(Entity e) {
+    const uint32_t i = EntityHandle::index(e);
+    entitySignatures[i] = 0;
+#if SAC_LINUX && SAC_DESKTOP
+    entityTemplateLibrary.remove(e);
+#endif
+    setName(i, 0);
+    // invalidate handles to this entity
+    entityGenerations[i] = (entityGenerations[i] + 1) % EntityHandle::GenerationCount;
+    LOGV(2, "Entity " << e << " is ready for recycling");
+    recyclableEntities.emplace_front(i);
+}
 
-    if (e >= _entityHash.size())
-        _entityHash.resize(2 * (_entityHash.size() + 1));
-    _entityHash[e] = id;
+Entity EntityManager::CreateEntity(const hash_t id, EntityType::Enum type, EntityTemplateRef tmpl) {
+    Entity e = nextEntityId();
+    const uint32_t i = EntityHandle::index(e);
+
+    setName(i, id);
+    // Tag
+    entitySignatures[i] = AliveBit | (type == EntityType::Persistent ? PersistentBit : 0);
+    aliveEntityCount++;
 
     if (tmpl != InvalidEntityTemplateRef) {
         // add component
         entityTemplateLibrary.applyEntityTemplate(e, tmpl);
     }
+    return e;
+}
 
-    // Tag
-    switch (type) {
-        case EntityType::Volatile:
-            break;
-        case EntityType::Persistent:
-            permanentEntities.push_back(e);
-            break;
+void EntityManager::CreateEntities(unsigned count, Entity* out, const hash_t id, EntityType::Enum type) {
+    for (unsigned i=0; i<count; i++) {
+        out[i] = nextEntityId();
     }
-    return e;
+
+    const ComponentSignature tag = AliveBit | (type == EntityType::Persistent ? PersistentBit : 0);
+    for (unsigned i=0; i<count; i++) {
+        setName(EntityHandle::index(out[i]), id);
+        entitySignatures[EntityHandle::index(out[i])] = tag;
+    }
+    aliveEntityCount += count;
 }
 
 Entity EntityManager::CreateEntityFromTemplate(const char* name, EntityType::Enum type) {
@@ -124,11 +182,11 @@ Entity EntityManager::CreateEntityFromTemplate(const char* name, EntityType::Enu
 const char* EntityManager::entityName(Entity e) const {
     static const char* u = "unknown";
 
-    if (e >= _entityHash.size()) {
+    if (EntityHandle::index(e) >= _entityHash.size()) {
         LOGE("Undefined (not initialiazed ?) entity '" << e << "' used");
         return u;
     }
-    hash_t id = _entityHash[e];
+    hash_t id = _entityHash[EntityHandle::index(e)];
     if (id)
 #if SAC_DEBUG
         return Murmur::lookup(id);
@@ -141,61 +199,92 @@ const char* EntityManager::entityName(Entity e) const {
 #endif
 
 Entity EntityManager::getEntityByName(hash_t id) const {
-    Entity byName = 0;
-#if SAC_DEBUG
-    bool found = false;
-#endif
+    if (!id)
+        return 0;
+    auto it = nameIndex.find(id);
+    if (it == nameIndex.end())
+        return 0;
+
+    const uint32_t index = *it->second.begin();
+    LOGW_IF(it->second.size() > 1, "Requesting entity by name, but multiple entities share the same id: '" << id << "' / name: " << INV_HASH(id));
+    return EntityHandle::make(index, entityGenerations[index]);
+}
 
-    const auto count = _entityHash.size();
-    for (unsigned i=0; i<count; i++) {
-        if (_entityHash[i] == id) {
-            byName = i;
-#if SAC_DEBUG
-            if (found) {
-                LOGW("Requesting entity by name, but multiple entities share the same id: '" << id << "' / name: " << Murmur::lookup(id));
-            }
-            found = true;
-#else
-            break;
-#endif
-        }
+std::vector<Entity> EntityManager::getEntitiesByName(hash_t id) const {
+    std::vector<Entity> out;
+    if (!id)
+        return out;
+    auto it = nameIndex.find(id);
+    if (it == nameIndex.end())
+        return out;
+    out.reserve(it->second.size());
+    for (uint32_t index: it->second) {
+        out.push_back(EntityHandle::make(index, entityGenerations[index]));
     }
+    return out;
+}
 
-    return byName;
+unsigned EntityManager::entityCountWithName(hash_t id) const {
+    if (!id)
+        return 0;
+    auto it = nameIndex.find(id);
+    return it == nameIndex.end() ? 0 : it->second.size();
 }
 
 void EntityManager::DeleteEntity(Entity e) {
-    auto i = entityComponents.find(e);
-
 #if SAC_DEBUG
     auto del = entityDeletionTime.find(e);
     LOGE_IF(del != entityDeletionTime.end(), "Entity already deleted at: " << del->second.first);
 #endif
-    LOGF_IF(i == entityComponents.end(), "DeleteEntity requested with invalid entity " <<
+    LOGF_IF(!isAlive(e),
+        "DeleteEntity requested with invalid entity " <<
         e << "('" << entityName(e) << "') (did you already removed it?)");
 #if SAC_DEBUG
     entityDeletionTime[e] = std::make_pair(TimeUtil::GetTime(), entityName(e));
 #endif
 
-    std::list<ComponentSystem*>& l = i->second;
+    for (ComponentSignature s = signature(e); s; s &= s - 1) {
+        ComponentSystem::GetBySignatureBit(lowestBit(s))->Delete(e);
+    }
+    aliveEntityCount--;
+    recycle(e);
+}
 
-    for (std::list<ComponentSystem*>::iterator it=l.begin(); it!=l.end(); ++it) {
-        (*it)->Delete(e);
+void EntityManager::DeleteEntities(const Entity* entities, unsigned count) {
+    ComponentSignature all = 0;
+    for (unsigned i=0; i<count; i++) {
+        const Entity e = entities[i];
+#if SAC_DEBUG
+        auto del = entityDeletionTime.find(e);
+        LOGE_IF(del != entityDeletionTime.end(), "Entity already deleted at: " << del->second.first);
+#endif
+        LOGF_IF(!isAlive(e),
+            "DeleteEntities requested with invalid entity " <<
+            e << "('" << entityName(e) << "') (did you already removed it?)");
+#if SAC_DEBUG
+        entityDeletionTime[e] = std::make_pair(TimeUtil::GetTime(), entityName(e));
+#endif
+        all |= signature(e);
     }
-    entityComponents.erase(e);
 
+    // then remove components, one system at a time
+    FrameVector<Entity> owners;
+    owners.reserve(count);
+    for (ComponentSignature s = all & ~ReservedBits; s; s &= s - 1) {
+        const unsigned bit = lowestBit(s);
+        const ComponentSignature mask = ((ComponentSignature)1) << bit;
+        owners.clear();
+        for (unsigned i=0; i<count; i++) {
+            if (entitySignatures[EntityHandle::index(entities[i])] & mask)
+                owners.push_back(entities[i]);
+        }
+        ComponentSystem::GetBySignatureBit(bit)->DeleteMany(owners.data(), owners.size());
+    }
 
-#if SAC_LINUX && SAC_DESKTOP
-    entityTemplateLibrary.remove(e);
-#endif
-    {
-        _entityHash[e] = 0;
+    for (unsigned i=0; i<count; i++) {
+        recycle(entities[i]);
     }
-    LOGV(2, "Entity " << e << " is ready for recycling");
-    recyclableEntities.emplace_front(e);
-    auto it = std::find(permanentEntities.begin(), permanentEntities.end(), e);
-    if (it != permanentEntities.end())
-        permanentEntities.erase(it);
+    aliveEntityCount -= count;
 }
 
 #if SAC_DEBUG
@@ -207,23 +296,37 @@ void EntityManager::validateEntity(Entity e) const {
 }
 #endif
 
-void EntityManager::AddComponent(Entity e, ComponentSystem* system, bool LOG_USAGE_ONLY(fail)) {
-#if SAC_DEBUG
-    {
-        const auto it = entityComponents[e];
-        if (std::find(it.begin(), it.end(), system) != it.end()) {
-            LOGF_IF(fail, "Entity '" << entityName(e) << "' already has a component '" << INV_HASH(system->getId()) << "'");
-            return;
-        }
+void EntityManager::AddComponent(Entity e, ComponentSystem* system, bool fail) {
+    LOGF_IF(!isAlive(e),
+        "AddComponent requested on invalid entity " << e);
+    const ComponentSignature bit = system->getSignature();
+    ComponentSignature& sig = entitySignatures[EntityHandle::index(e)];
+    if (sig & bit) {
+        LOGF_IF(fail, "Entity '" << entityName(e) << "' already has a component '" << INV_HASH(system->getId()) << "'");
+        return;
     }
-#endif
     system->Add(e);
-    entityComponents[e].push_back(system);
+    sig |= bit;
+}
+
+void EntityManager::AddComponentToEntities(const Entity* entities, unsigned count, std::initializer_list<ComponentSystem*> systems) {
+    for (auto* system: systems) {
+        const ComponentSignature bit = system->getSignature();
+        for (unsigned i=0; i<count; i++) {
+            LOGF_IF(!isAlive(entities[i]),
+                "AddComponentToEntities requested on invalid entity " << entities[i]);
+            ComponentSignature& sig = entitySignatures[EntityHandle::index(entities[i])];
+            LOGF_IF(sig & bit, "Entity '" << entityName(entities[i]) << "' already has a component '" << INV_HASH(system->getId()) << "'");
+            sig |= bit;
+        }
+        system->AddMany(entities, count);
+    }
 }
 
 void EntityManager::RemoveComponent(Entity e, ComponentSystem* system) {
+    LOGF_IF(!isAlive(e), "RemoveComponent requested on invalid entity " << e);
     system->Delete(e);
-    entityComponents[e].remove(system);
+    entitySignatures[EntityHandle::index(e)] &= ~system->getSignature();
 }
 
 void EntityManager::deleteAllEntities() {
@@ -233,16 +336,60 @@ void EntityManager::deleteAllEntities() {
     nextEntity = 1;
     recyclableEntities.clear();
     _entityHash.clear();
+    nameIndex.clear();
+    entitySignatures.clear();
+    // entityGenerations is kept, so handles to deleted entities stay invalid
 
-    LOGF_IF (entityComponents.size() != 0, "entityComponents not empty after deleting all entities");
+    LOGF_IF (aliveEntityCount != 0, "entity count not null after deleting all entities");
+}
+
+size_t EntityManager::compact() {
+    // slots above the highest live entity go back to the 'never used' pool
+    uint32_t end = nextEntity;
+    while (end > 1 && !(entitySignatures[end - 1] & AliveBit)) {
+        end--;
+    }
+    nextEntity = end;
+    recyclableEntities.remove_if([end] (uint32_t i) -> bool { return i >= end; });
+    recyclableEntities.sort();
+
+    size_t freed = 0;
+    if (end < _entityHash.size()) {
+        freed += (_entityHash.size() - end) * (sizeof(hash_t) + sizeof(ComponentSignature));
+        _entityHash.resize(end);
+        entitySignatures.resize(end);
+    }
+    // entityGenerations is kept (1 byte per slot), so stale handles stay stale
+    _entityHash.shrink_to_fit();
+    entitySignatures.shrink_to_fit();
+    nameIndex.rehash(0);
+
+    for (auto& s: ComponentSystem::registeredSystems()) {
+        freed += s.second->compact();
+    }
+    lastCompactedEnd = end;
+    LOGI("Compaction: " << freed << " bytes reclaimed, " << aliveEntityCount << " entities in " << end << " slots");
+    return freed;
+}
+
+void EntityManager::autoCompact() {
+    // don't bother with small tables, and wait for slots to be used again
+    // after a compaction which couldn't release the highest ones
+    static const uint32_t MinSlots = 1024;
+    if (autoCompactOccupancy <= 0 || nextEntity < MinSlots || nextEntity == lastCompactedEnd)
+        return;
+    if (aliveEntityCount < autoCompactOccupancy * nextEntity) {
+        compact();
+    }
 }
 
 std::vector<Entity> EntityManager::allEntities() {
     std::vector<Entity> out;
-    out.reserve(entityComponents.size());
-    for (std::map<Entity, std::list<ComponentSystem*> >::iterator it=entityComponents.begin();
-        it!=entityComponents.end(); ++it) {
-        out.push_back(it->first);
+    out.reserve(aliveEntityCount);
+    const uint32_t count = entitySignatures.size();
+    for (uint32_t i=0; i<count; i++) {
+        if (entitySignatures[i] & AliveBit)
+            out.push_back(EntityHandle::make(i, entityGenerations[i]));
     }
     return out;
 }
@@ -272,18 +419,22 @@ int EntityManager::serialize(uint8_t** result) {
     //      * component size
     //      * component
 
-    for (auto _e: permanentEntities) {
+    const uint32_t count = entitySignatures.size();
+    for (uint32_t i=0; i<count; i++) {
+        if (!(entitySignatures[i] & PersistentBit))
+            continue;
         EntitySave e;
-        e.e = _e;
-        auto j = entityComponents.find(_e);
-        LOGE_IF(j == entityComponents.end(), "Permanent entity found " << theEntityManager.entityName(e.e) << " without components");
+        e.e = EntityHandle::make(i, entityGenerations[i]);
+        const ComponentSignature sig = signature(e.e);
+        LOGE_IF(sig == 0, "Permanent entity found " << theEntityManager.entityName(e.e) << " without components");
 
-        if (j == entityComponents.end())
+        if (sig == 0)
             continue;
 
         totalLength += sizeof(Entity) + sizeof(hash_t) + sizeof(int);
 
-        for(auto* sys: j->second) {
+        for (ComponentSignature s = sig; s; s &= s - 1) {
+            ComponentSystem* sys = ComponentSystem::GetBySignatureBit(lowestBit(s));
             ComponentSave c;
             c.id = sys->getId();
             c.contentSize = sys->serialize(e.e, &c.content);
@@ -301,7 +452,7 @@ int EntityManager::serialize(uint8_t** result) {
         // entity (id)
         out = (uint8_t*)mempcpy(out, &saves[i].e, sizeof(Entity));
         // hash
-        out = (uint8_t*) mempcpy(out, &_entityHash[saves[i].e], sizeof(hash_t));
+        out = (uint8_t*) mempcpy(out, &_entityHash[EntityHandle::index(saves[i].e)], sizeof(hash_t));
 
         // nb component
         const int cCount = saves[i].components.size();
@@ -323,18 +474,20 @@ void EntityManager::deserialize(const uint8_t* in, int length) {
         Entity e;
         memcpy(&e, &in[index], sizeof(e)); index += sizeof(e);
 
-        permanentEntities.push_back(e);
-
         hash_t id = 0;
         memcpy(&id, &in[index], sizeof(hash_t)); index += sizeof(hash_t);
-        if (e >= _entityHash.size())
-            _entityHash.resize(2 * (_entityHash.size() + 1));
-        _entityHash[e] = id;
+        const uint32_t slot = EntityHandle::index(e);
+        ensureCapacity(slot);
+        setName(slot, id);
+        if (!(entitySignatures[slot] & AliveBit)) {
+            aliveEntityCount++;
+        }
+        entitySignatures[slot] |= AliveBit | PersistentBit;
+        entityGenerations[slot] = EntityHandle::generation(e);
 
         int cCount = 0;
         memcpy(&cCount, &in[index], sizeof(int)); index += sizeof(int);
 
-        std::list<ComponentSystem*> l;
         for (int i=0; i<cCount; i++) {
             hash_t systemId;
             memcpy(&systemId, &in[index], sizeof(hash_t));
@@ -349,12 +502,9 @@ void EntityManager::deserialize(const uint8_t* in, int length) {
             memcpy(b, &in[index], size); index += size;
             system->deserialize(e, b, size);
             delete[] b;
-
-            l.push_back(system);
         }
-        entityComponents[e] = l;
-        LOGI( " - restored entity '" << e << "' / '" << entityName(e) << "' with "  << l.size() << " components");
-        nextEntity = glm::max(nextEntity, e + 1);
+        LOGI( " - restored entity '" << e << "' / '" << entityName(e) << "' with "  << cCount << " components");
+        nextEntity = glm::max(nextEntity, slot + 1);
     }
 }
 
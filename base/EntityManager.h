@@ -26,21 +26,19 @@
 #define theEntityManager (*EntityManager::Instance())
 
 #include <map>
+#include <set>
+#include <unordered_map>
 #include <forward_list>
 #include <vector>
+#include <initializer_list>
 
 #define ADD_COMPONENT(entity, type) theEntityManager.AddComponent((entity), &type##System::GetInstance())
 
 #include "systems/opengl/EntityTemplateLibrary.h"
+#include "EntityCommandBuffer.h"
 
 class ComponentSystem;
 
-namespace EntityType {
-    enum Enum {
-        Volatile,
-        Persistent
-    };
-}
 class EntityManager {
     private:
         static EntityManager* instance;
@@ -62,15 +60,42 @@ class EntityManager {
         void DeleteEntity(Entity e);
         void AddComponent(Entity e, ComponentSystem* system, bool failIfAlreadyHas = true);
         void RemoveComponent(Entity e, ComponentSystem* system);
+
+        // Bulk versions of CreateEntity/AddComponent/DeleteEntity
+        void CreateEntities(unsigned count, Entity* out, const hash_t id
+            , EntityType::Enum type = EntityType::Volatile);
+        void AddComponentToEntities(const Entity* entities, unsigned count,
+            std::initializer_list<ComponentSystem*> systems);
+        void DeleteEntities(const Entity* entities, unsigned count);
         void deleteAllEntities();
         std::vector<Entity> allEntities();
         unsigned entityCount() const;
 
+        // false for deleted entities, including when their slot has been
+        // reused by another entity (see EntityHandle)
+        bool isAlive(Entity e) const {
+            const uint32_t i = EntityHandle::index(e);
+            return i < entitySignatures.size() &&
+                (entitySignatures[i] & AliveBit) &&
+                entityGenerations[i] == EntityHandle::generation(e);
+        }
+        ComponentSignature signature(Entity e) const {
+            return isAlive(e) ? (entitySignatures[EntityHandle::index(e)] & ~ReservedBits) : 0;
+        }
+        // true if entity has a component in every system of 'required'
+        bool hasComponents(Entity e, ComponentSignature required) const {
+            return (signature(e) & required) == required;
+        }
+
         int serialize(uint8_t** result);
         void deserialize(const uint8_t* in, int size);
 
+        // O(1). If several entities share the name, the one with the lowest
+        // index is returned (use getEntitiesByName to get all of them)
         Entity getEntityByName(hash_t id) const;
-        hash_t entityHash(Entity e) const { return _entityHash[e]; }
+        std::vector<Entity> getEntitiesByName(hash_t id) const;
+        unsigned entityCountWithName(hash_t id) const;
+        hash_t entityHash(Entity e) const { return _entityHash[EntityHandle::index(e)]; }
 
 #if SAC_ENABLE_LOG || SAC_INGAME_EDITORS
         const char* entityName(Entity e) const;
@@ -79,24 +104,60 @@ class EntityManager {
         void renameEntity(Entity e, hash_t id);
 #endif
 
-        int getNumberofEntity() {return entityComponents.size();}
+        int getNumberofEntity() {return aliveEntityCount;}
+
+        // Shrinks entity tables and components storage to what's currently
+        // used, and makes sure free slots are reused lowest first. Entities
+        // are not renumbered: slots above the highest live entity are
+        // released, holes below it are not.
+        // Returns the number of bytes reclaimed.
+        size_t compact();
+        // Compact automatically (see autoCompact) once less than
+        // 'minOccupancy' of the used slots hold a live entity. 0 disables it.
+        void setAutoCompaction(float minOccupancy) { autoCompactOccupancy = minOccupancy; }
+        // Called by Game at sync points, when no system is being updated
+        void autoCompact();
 
 #if SAC_DEBUG
         void validateEntity(Entity e) const;
 #endif
     private:
-        Entity nextEntity;
-        std::forward_list<Entity> recyclableEntities;
+        void ensureCapacity(uint32_t index);
+        Entity nextEntityId();
+        void recycle(Entity e);
+        // updates _entityHash and nameIndex
+        void setName(uint32_t index, hash_t id);
+
+        // next never used slot, and slots of deleted entities
+        uint32_t nextEntity;
+        std::forward_list<uint32_t> recyclableEntities;
 
-        std::list<Entity> permanentEntities;
         std::vector<hash_t> _entityHash;
-        std::map<Entity, std::list<ComponentSystem*> > entityComponents;
+        // name -> indices of entities using it (unnamed entities are not indexed).
+        // Sorted, so renaming/deleting one of many same-named entities stays cheap
+        std::unordered_map<hash_t, std::set<uint32_t>> nameIndex;
+
+        // entity -> set of systems it belongs to (one bit per system, see
+        // ComponentSystem::getSignature). Last 2 bits mark live and
+        // persistent entities.
+        static const ComponentSignature AliveBit = ((ComponentSignature)1) << 63;
+        static const ComponentSignature PersistentBit = ((ComponentSignature)1) << 62;
+        static const ComponentSignature ReservedBits = AliveBit | PersistentBit;
+        std::vector<ComponentSignature> entitySignatures;
+        // slot -> generation of the entity using it (or the next one if free)
+        std::vector<uint8_t> entityGenerations;
+        unsigned aliveEntityCount;
+
+        float autoCompactOccupancy;
+        uint32_t lastCompactedEnd;
 
 #if SAC_DEBUG
         std::map<Entity, std::pair<float, std::string> > entityDeletionTime;
 #endif
     public:
         EntityTemplateLibrary entityTemplateLibrary;
+        // structural changes requested during systems update
+        EntityCommandBuffer deferred;
 };
 
 void deleteEntityFunctor(Entity e);
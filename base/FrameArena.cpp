@@ -0,0 +1,115 @@
+/*
+    This file is part of Soupe Au Caillou.
+
+    @author Soupe au Caillou - Jordane Pelloux-Prayer
+    @author Soupe au Caillou - Gautier Pelloux-Prayer
+    @author Soupe au Caillou - Pierre-Eric Pelloux-Prayer
+
+    Soupe Au Caillou is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3.
+
+    Soupe Au Caillou is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Soupe Au Caillou.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "FrameArena.h"
+
+#include "base/Log.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+
+FrameArena::FrameArena(size_t blockSize) : offset(0), previousBlocksUsed(0) {
+    Block b;
+    b.size = blockSize;
+    b.data = static_cast<uint8_t*>(malloc(blockSize));
+    blocks.push_back(b);
+}
+
+FrameArena::~FrameArena() {
+    for (auto& b: blocks) {
+        free(b.data);
+    }
+}
+
+void* FrameArena::allocate(size_t size, size_t alignment) {
+    Block* block = &blocks.back();
+    uintptr_t start = reinterpret_cast<uintptr_t>(block->data) + offset;
+    uintptr_t aligned = (start + alignment - 1) & ~(uintptr_t)(alignment - 1);
+
+    if (aligned + size > reinterpret_cast<uintptr_t>(block->data) + block->size) {
+        // current block is full: chain a bigger one. They're merged on reset
+        Block b;
+        b.size = std::max(2 * block->size, size + alignment);
+        b.data = static_cast<uint8_t*>(malloc(b.size));
+        LOGV(1, "Frame arena grows: +" << b.size << " bytes");
+        previousBlocksUsed += offset;
+        blocks.push_back(b);
+
+        block = &blocks.back();
+        offset = 0;
+        start = reinterpret_cast<uintptr_t>(block->data);
+        aligned = (start + alignment - 1) & ~(uintptr_t)(alignment - 1);
+    }
+    offset = aligned + size - reinterpret_cast<uintptr_t>(block->data);
+    return reinterpret_cast<void*>(aligned);
+}
+
+void FrameArena::release(void* p, size_t size) {
+    const Block& block = blocks.back();
+    if (static_cast<uint8_t*>(p) + size == block.data + offset) {
+        offset = static_cast<uint8_t*>(p) - block.data;
+    }
+}
+
+void FrameArena::reset() {
+    if (blocks.size() > 1) {
+        // replace all blocks by one big enough for the whole frame
+        const size_t total = capacity();
+        for (auto& b: blocks) {
+            free(b.data);
+        }
+        blocks.resize(1);
+        blocks[0].size = total;
+        blocks[0].data = static_cast<uint8_t*>(malloc(total));
+    }
+    offset = previousBlocksUsed = 0;
+}
+
+size_t FrameArena::capacity() const {
+    size_t total = 0;
+    for (const auto& b: blocks) {
+        total += b.size;
+    }
+    return total;
+}
+
+static std::mutex arenasMutex;
+static std::vector<std::unique_ptr<FrameArena> > arenas;
+
+FrameArena& FrameArena::current() {
+    // kept until exit: threads using them (job system workers) live as
+    // long as the game
+    static thread_local FrameArena* arena = 0;
+    if (!arena) {
+        std::lock_guard<std::mutex> lock(arenasMutex);
+        arenas.push_back(std::unique_ptr<FrameArena>(new FrameArena()));
+        arena = arenas.back().get();
+    }
+    return *arena;
+}
+
+void FrameArena::ResetAll() {
+    std::lock_guard<std::mutex> lock(arenasMutex);
+    for (auto& a: arenas) {
+        a->reset();
+    }
+}
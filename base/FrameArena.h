@@ -0,0 +1,107 @@
+/*
+    This file is part of Soupe Au Caillou.
+
+    @author Soupe au Caillou - Jordane Pelloux-Prayer
+    @author Soupe au Caillou - Gautier Pelloux-Prayer
+    @author Soupe au Caillou - Pierre-Eric Pelloux-Prayer
+
+    Soupe Au Caillou is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3.
+
+    Soupe Au Caillou is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Soupe Au Caillou.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Linear allocator for data living at most one frame (temporary arrays
+// built by systems during their update). Allocation is a pointer bump,
+// individual frees are no-ops (except for the most recent allocation) and
+// everything is released at once by reset(), at the end of Game::step.
+//
+// When a frame needs more than the current block, extra blocks are
+// allocated and merged into a single one on the next reset(): after a few
+// frames, a steady-state frame doesn't touch the heap anymore.
+//
+// Each thread has its own arena (see current()), so no locking is needed,
+// but memory must be released on the thread which allocated it.
+class FrameArena {
+    public:
+        static const size_t DefaultBlockSize = 64 * 1024;
+        static const size_t DefaultAlignment = 16;
+
+        FrameArena(size_t blockSize = DefaultBlockSize);
+        ~FrameArena();
+
+        void* allocate(size_t size, size_t alignment = DefaultAlignment);
+        template <typename T>
+        T* allocate(size_t count) {
+            return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+        }
+        // Only gives back memory if 'p' is the latest allocation (so a
+        // growing vector can reuse it), otherwise waits for reset()
+        void release(void* p, size_t size);
+
+        // Invalidates every allocation made since the previous reset
+        void reset();
+
+        // bytes allocated since the last reset / total reserved
+        size_t used() const { return previousBlocksUsed + offset; }
+        size_t capacity() const;
+
+        // Arena of the calling thread
+        static FrameArena& current();
+        // Resets the arenas of all threads. Must be called when no system runs.
+        static void ResetAll();
+
+    private:
+        FrameArena(const FrameArena&);
+        FrameArena& operator=(const FrameArena&);
+
+        struct Block {
+            uint8_t* data;
+            size_t size;
+        };
+        // the last one is the one in use
+        std::vector<Block> blocks;
+        size_t offset, previousBlocksUsed;
+};
+
+// STL allocator using a FrameArena (by default the calling thread's one).
+// Containers using it must not outlive the frame.
+template <typename T>
+struct FrameAllocator {
+    typedef T value_type;
+
+    FrameAllocator() : arena(&FrameArena::current()) {}
+    FrameAllocator(FrameArena& a) : arena(&a) {}
+    template <typename U>
+    FrameAllocator(const FrameAllocator<U>& other) : arena(other.arena) {}
+
+    T* allocate(size_t n) { return arena->allocate<T>(n); }
+    void deallocate(T* p, size_t n) { arena->release(p, n * sizeof(T)); }
+
+    FrameArena* arena;
+};
+
+template <typename T, typename U>
+inline bool operator==(const FrameAllocator<T>& a, const FrameAllocator<U>& b) {
+    return a.arena == b.arena;
+}
+template <typename T, typename U>
+inline bool operator!=(const FrameAllocator<T>& a, const FrameAllocator<U>& b) {
+    return a.arena != b.arena;
+}
+
+template <typename T>
+using FrameVector = std::vector<T, FrameAllocator<T> >;
@@ -0,0 +1,136 @@
+/*
+    This file is part of Soupe Au Caillou.
+
+    @author Soupe au Caillou - Jordane Pelloux-Prayer
+    @author Soupe au Caillou - Gautier Pelloux-Prayer
+    @author Soupe au Caillou - Pierre-Eric Pelloux-Prayer
+
+    Soupe Au Caillou is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3.
+
+    Soupe Au Caillou is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Soupe Au Caillou.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "FrameStats.h"
+#include "base/Log.h"
+
+#include <fstream>
+
+const unsigned DurationHistogram::BucketCount;
+const unsigned DurationHistogram::BucketWidth;
+
+DurationHistogram::DurationHistogram() {
+    reset();
+}
+
+void DurationHistogram::add(float seconds) {
+    const uint32_t micros = seconds > 0 ? (uint32_t)(seconds * 1000000) : 0;
+    unsigned index = micros / BucketWidth;
+    if (index >= BucketCount)
+        index = BucketCount - 1;
+
+    buckets[index].fetch_add(1, std::memory_order_relaxed);
+    samples.fetch_add(1, std::memory_order_relaxed);
+    totalMicros.fetch_add(micros, std::memory_order_relaxed);
+
+    uint32_t previous = maxMicros.load(std::memory_order_relaxed);
+    while (micros > previous &&
+        !maxMicros.compare_exchange_weak(previous, micros, std::memory_order_relaxed)) {}
+}
+
+void DurationHistogram::reset() {
+    for (auto& b: buckets) {
+        b.store(0, std::memory_order_relaxed);
+    }
+    samples.store(0, std::memory_order_relaxed);
+    maxMicros.store(0, std::memory_order_relaxed);
+    totalMicros.store(0, std::memory_order_relaxed);
+}
+
+float DurationHistogram::mean() const {
+    const uint32_t n = count();
+    return n ? totalMicros.load(std::memory_order_relaxed) / (n * 1000000.0f) : 0;
+}
+
+float DurationHistogram::max() const {
+    return maxMicros.load(std::memory_order_relaxed) / 1000000.0f;
+}
+
+float DurationHistogram::percentile(float percent) const {
+    // (samples may be added meanwhile: stop at the last non-empty bucket)
+    const uint64_t n = count();
+    if (!n)
+        return 0;
+    const uint64_t target = (uint64_t)(n * percent / 100.0f + 0.5f);
+    uint64_t seen = 0;
+    unsigned last = 0;
+    for (unsigned i=0; i<BucketCount; i++) {
+        const uint32_t c = bucket(i);
+        if (!c)
+            continue;
+        seen += c;
+        last = i;
+        if (seen >= target)
+            break;
+    }
+    if (last == BucketCount - 1)
+        return max();
+    return ((last + 1) * BucketWidth) / 1000000.0f;
+}
+
+void FrameStats::reset() {
+    for (auto& h: steps) {
+        h.reset();
+    }
+    droppedUpdates.store(0);
+}
+
+static const char* stepName(FrameStep::Enum step) {
+    switch (step) {
+        case FrameStep::Update: return "update";
+        case FrameStep::Render: return "render";
+        case FrameStep::Wait: return "wait";
+        default: return "?";
+    }
+}
+
+void FrameStats::report(std::ostream& out) const {
+    for (int i=0; i<FrameStep::Count; i++) {
+        const DurationHistogram& h = steps[i];
+        out << stepName((FrameStep::Enum)i) << ": " << h.count() << " frames, ms mean/p50/p95/p99/max: "
+            << 1000 * h.mean() << '/' << 1000 * h.percentile(50) << '/'
+            << 1000 * h.percentile(95) << '/' << 1000 * h.percentile(99) << '/'
+            << 1000 * h.max() << '\n';
+    }
+    out << "dropped updates: " << droppedUpdates.load() << '\n';
+}
+
+bool FrameStats::dump(const std::string& path) const {
+    std::ofstream out(path.c_str());
+    if (!out) {
+        LOGE("Cannot write frame stats to '" << path << "'");
+        return false;
+    }
+    report(out);
+
+    // non-empty buckets: <step> <bucket start in ms> <sample count>
+    for (int i=0; i<FrameStep::Count; i++) {
+        const DurationHistogram& h = steps[i];
+        for (unsigned b=0; b<DurationHistogram::BucketCount; b++) {
+            const uint32_t c = h.bucket(b);
+            if (c) {
+                out << stepName((FrameStep::Enum)i) << ' '
+                    << (b * DurationHistogram::BucketWidth) / 1000.0f << ' ' << c << '\n';
+            }
+        }
+    }
+    LOGI("Frame stats written to '" << path << "'");
+    return true;
+}
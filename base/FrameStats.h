@@ -0,0 +1,84 @@
+/*
+    This file is part of Soupe Au Caillou.
+
+    @author Soupe au Caillou - Jordane Pelloux-Prayer
+    @author Soupe au Caillou - Gautier Pelloux-Prayer
+    @author Soupe au Caillou - Pierre-Eric Pelloux-Prayer
+
+    Soupe Au Caillou is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3.
+
+    Soupe Au Caillou is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Soupe Au Caillou.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// Histogram of durations, 0.1 ms buckets up to 100 ms (longer ones share a
+// last bucket). Samples can be added from any thread without locking.
+class DurationHistogram {
+    public:
+        static const unsigned BucketCount = 1000;
+        // in microseconds
+        static const unsigned BucketWidth = 100;
+
+        DurationHistogram();
+
+        void add(float seconds);
+        void reset();
+
+        uint32_t count() const { return samples.load(std::memory_order_relaxed); }
+        float mean() const;
+        float max() const;
+        // Duration under which 'percent' % of samples are (upper bound of
+        // their bucket), in seconds
+        float percentile(float percent) const;
+        // samples in [i * BucketWidth, (i + 1) * BucketWidth[ microseconds
+        uint32_t bucket(unsigned i) const { return buckets[i].load(std::memory_order_relaxed); }
+
+    private:
+        DurationHistogram(const DurationHistogram&);
+        DurationHistogram& operator=(const DurationHistogram&);
+
+        std::atomic<uint32_t> buckets[BucketCount];
+        std::atomic<uint32_t> samples, maxMicros;
+        std::atomic<uint64_t> totalMicros;
+};
+
+namespace FrameStep {
+    enum Enum {
+        // simulation and rendering frame production (game thread)
+        Update = 0,
+        // drawing (render thread)
+        Render,
+        // sleeping until the next update is due (game thread)
+        Wait,
+        Count
+    };
+}
+
+// Durations of each frame step (see Game::frameStats)
+struct FrameStats {
+    FrameStats() : droppedUpdates(0) {}
+
+    DurationHistogram steps[FrameStep::Count];
+    // updates skipped to limit catching up (see Game::maxUpdatesPerStep)
+    std::atomic<uint32_t> droppedUpdates;
+
+    void reset();
+    // count, mean, p50/p95/p99 and max of each histogram
+    void report(std::ostream& out) const;
+    // report + full histograms, returns false if 'path' can't be written
+    bool dump(const std::string& path) const;
+};
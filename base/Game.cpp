@@ -33,6 +33,8 @@
 
 #include "base/Common.h"
 #include "base/EntityManager.h"
+#include "base/FrameArena.h"
+#include "base/JobSystem.h"
 #include "base/PlacementHelper.h"
 #include "base/Profiler.h"
 #include "base/TimeUtil.h"
@@ -76,6 +78,8 @@
 #include "util/Recorder.h"
 #include "util/Tuning.h"
 
+#include <sstream>
+
 #if ! SAC_MOBILE
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_events.h>
@@ -91,8 +95,10 @@ Game::Game() {
     gameType = GameType::Default;
 #endif
     targetDT = 1.0f / 60.0f;
+    maxUpdatesPerStep = 5;
 
     isFinished = false;
+    fastForward = false;
 
 #if !SAC_MOBILE
     mouseNativeTouchState = 0;
@@ -169,7 +175,21 @@ Game::Game() {
     // default
     buildOrderedSystemsToUpdateList();
 
-    fpsStats.reset(0);
+#if !SAC_EMSCRIPTEN
+    {
+        // game and render threads are already busy. Systems are updated as
+        // jobs too (see SystemScheduler), and the game thread runs jobs while
+        // waiting for them
+        const unsigned cores = std::thread::hardware_concurrency();
+        theJobSystem.setWorkerCount(cores > 2 ? cores - 2 : 0);
+    }
+#endif
+
+#if SAC_MOBILE
+    // give memory back after levels creating lots of entities
+    theEntityManager.setAutoCompaction(0.25f);
+#endif
+
     lastUpdateTime = TimeUtil::GetTime();
 #if SAC_INGAME_EDITORS
     levelEditor = new LevelEditor(this);
@@ -262,6 +282,8 @@ void Game::buildOrderedSystemsToUpdateList() {
 #endif
 
 
+    systemScheduler.build(orderedSystemsToUpdate);
+
     LOGV(1, orderedSystemsToUpdate.size() << " active systems");
 }
 
@@ -532,12 +554,14 @@ void Game::sacInitFromRenderThread() {
     io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
 
     // Load font texture
-    glGenTextures(1, &RenderingSystem::fontTex);
-    glBindTexture(GL_TEXTURE_2D, RenderingSystem::fontTex);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    if (!theRenderingSystem.headless) {
+        glGenTextures(1, &RenderingSystem::fontTex);
+        glBindTexture(GL_TEXTURE_2D, RenderingSystem::fontTex);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    }
 
     io.Fonts->TexID = (void*)(intptr_t)RenderingSystem::fontTex;
 #endif
@@ -559,31 +583,6 @@ void Game::sacInitFromGameThread() {
 
     tuning.init(gameThreadContext->assetAPI);
     tuning.load("tuning.ini");
-
-#if SAC_DEBUG
-    glm::vec2 size = glm::vec2(TRANSFORM(camera)->size.x / FPS_DEBUG_N, 0);
-    glm::vec2 bottomLeft = TRANSFORM(camera)->size * glm::vec2(-0.5f, -0.5f) - size.x  * 0.5f;
-
-    for (int i=0; i<FPS_DEBUG_N; i++) {
-        fpsStats.square[i] = theEntityManager.CreateEntity(HASH("__/square", 0x5b913efb));
-        ADD_COMPONENT(fpsStats.square[i], Transformation);
-        TRANSFORM(fpsStats.square[i])->size = size;
-        TRANSFORM(fpsStats.square[i])->position = bottomLeft + size * (float)i;
-        ADD_COMPONENT(fpsStats.square[i], Rendering);
-        // RENDERING(fpsStats.square[i])->show = true;
-        RENDERING(fpsStats.square[i])->color = Color::palette(i / (float)FPS_DEBUG_N, 0.5f);
-        RENDERING(fpsStats.square[i])->flags = RenderingFlags::NonOpaque;
-
-        fpsStats.text[i] = theEntityManager.CreateEntity(HASH("__/text", 0xba2ddac9));
-        ADD_COMPONENT(fpsStats.text[i], Transformation);
-        TRANSFORM(fpsStats.text[i])->position = glm::vec2(TRANSFORM(fpsStats.square[i])->position.x, (i % 2) * size.x * 2);
-        ADD_COMPONENT(fpsStats.text[i], Text);
-        TEXT(fpsStats.text[i])->text = "0.016";
-        TEXT(fpsStats.text[i])->color = Color(0, 0, 0);
-        // TEXT(fpsStats.text[i])->show = true;
-        TEXT(fpsStats.text[i])->charHeight = 2 * size.x;
-    }
-#endif
 }
 
 int Game::saveState(uint8_t**) {
@@ -595,8 +594,11 @@ static float currentTime = 0.0f;
 void Game::step() {
     PROFILE("Game", "step", BeginEvent);
 
+    // unless pipelined, don't produce a frame before the last one was taken
     theRenderingSystem.waitDrawingComplete();
 
+    float waitTime = 0;
+
 delta_time_computation:
     float newTime = TimeUtil::GetTime();
     float frameTime = newTime - currentTime;
@@ -620,6 +622,11 @@ delta_time_computation:
     // targetDT = accumulator;
 #endif
 
+    if (fastForward) {
+        // one fixed update per step, whatever the elapsed time
+        accumulator = targetDT;
+    }
+
     /** dt calculation
      * rawFrameTime = raw calculated elpased time since last update
      * we want to always update with dt = 16ms
@@ -640,6 +647,7 @@ delta_time_computation:
     if (accumulator < targetDT) {
 #if !SAC_EMSCRIPTEN
         TimeUtil::Wait(targetDT - accumulator);
+        waitTime += TimeUtil::GetTime() - newTime;
         goto delta_time_computation;
 #else
         dtFix = accumulator - targetDT;
@@ -647,23 +655,18 @@ delta_time_computation:
 #endif
     }
 
-#if SAC_DEBUG
-    {
-        static int current = 0;
-        char tmp[64];
-        sprintf(tmp, "%d", (int)(accumulator * 1000));
-
-        float height = accumulator / (5 * targetDT);
-        TRANSFORM(fpsStats.square[current])->size.y = height;
-        TRANSFORM(fpsStats.square[current])->position.y =
-            TRANSFORM(camera)->size.y * (-0.5f) +
-            height * 0.5f;
-        TEXT(fpsStats.text[current])->text = tmp;
-        current = (current + 1) % FPS_DEBUG_N;
-        TEXT(fpsStats.text[current])->text = "...";
+    if (maxUpdatesPerStep) {
+        // each catch-up update makes this step longer, and the next one
+        // later: beyond the limit, drop late updates (time dilation)
+        const int late = (int)(accumulator / targetDT) - (int)maxUpdatesPerStep;
+        if (late > 0) {
+            LOGV(1, "Dropping " << late << " late update(s)");
+            accumulator -= late * targetDT;
+            frameStats.droppedUpdates += late;
+        }
     }
-#endif
 
+    frameStats.steps[FrameStep::Wait].add(waitTime);
     while (accumulator >= targetDT)
 #endif
 
@@ -676,7 +679,7 @@ delta_time_computation:
 
         // update game state
     #if SAC_INGAME_EDITORS
-        if (!doneOnce) {
+        if (!doneOnce && !fastForward) {
             doneOnce = true;
 
             LevelEditor::lock();
@@ -729,18 +732,22 @@ delta_time_computation:
 
             LOGV(3, "Update systems");
 
+            #if SAC_ENABLE_LOG
             for (auto* sys : orderedSystemsToUpdate) {
-                #if SAC_ENABLE_LOG
-                    //if system contains entities, remove it from "unused" systems set
-                    if (sys->entityCount()) {
-                        std::set<ComponentSystem*>::iterator systemIt;
-                        if ((systemIt = unusedSystems.find(sys)) != unusedSystems.end()) {
-                            unusedSystems.erase(systemIt);
-                        }
+                //if system contains entities, remove it from "unused" systems set
+                if (sys->entityCount()) {
+                    std::set<ComponentSystem*>::iterator systemIt;
+                    if ((systemIt = unusedSystems.find(sys)) != unusedSystems.end()) {
+                        unusedSystems.erase(systemIt);
                     }
-                #endif
-                sys->Update(targetDT);
+                }
             }
+            #endif
+            ComponentSystem::NextVersion();
+            systemScheduler.configure(tuning, targetDT);
+            systemScheduler.update(targetDT);
+            // sync point: apply structural changes requested by systems
+            theEntityManager.deferred.flush();
 
 #if SAC_INGAME_EDITORS
             if (gameType == GameType::SingleStep)
@@ -768,53 +775,53 @@ delta_time_computation:
         tick(targetDT);
     #endif
 
+        theEntityManager.deferred.flush();
+        theEntityManager.autoCompact();
+
         accumulator -= targetDT;
     }
 
     accumulator += dtFix;
 
-    LOGV(3, "Produce rendering frame");
-    // produce 1 new frame
+    if (!fastForward) {
+        LOGV(3, "Produce rendering frame");
+        // produce 1 new frame: the state after the last simulation step
 #if SAC_INGAME_EDITORS
-    if (gameType == GameType::Replay) {
-        int count = 0;
-        auto* commands = levelEditor->getFrame(&count);;
-        theRenderingSystem.forceRenderCommands(commands, count);
-        ImGui::Render();
-    } else {
-        theRenderingSystem.Update(frameTime);
-    }
+        if (gameType == GameType::Replay) {
+            int count = 0;
+            auto* commands = levelEditor->getFrame(&count);;
+            theRenderingSystem.forceRenderCommands(commands, count);
+            ImGui::Render();
+        } else {
+            theRenderingSystem.Update(targetDT);
+        }
 #else
-    theRenderingSystem.Update(frameTime);
+        theRenderingSystem.Update(targetDT);
 #endif
+    }
+
+    // temporary data of this step is not needed anymore
+    FrameArena::ResetAll();
+
+    frameStats.steps[FrameStep::Update].add(TimeUtil::GetTime() - currentTime);
 
     PROFILE("Game", "step", EndEvent);
 }
 
 void Game::render() {
     PROFILE("Game", "render-game", BeginEvent);
+    const float before = TimeUtil::GetTime();
     theRenderingSystem.render();
+    frameStats.steps[FrameStep::Render].add(TimeUtil::GetTime() - before);
 
-#if SAC_DEBUG
+#if SAC_ENABLE_LOG
     {
         static int count = 0;
-        static float prevT = 0;
-        float t = TimeUtil::GetTime();
-        float dt = t - prevT;
-        prevT = t;
-
-        if (dt > fpsStats.maxDt) {
-            fpsStats.maxDt = dt;
-        }
-        if (dt < fpsStats.minDt) {
-            fpsStats.minDt = dt;
-        }
-        ++count;
-        if (count == 3000) {
-            LOGI("FPS avg/min/max : " <<
-                (300.0 / (t - fpsStats.since)) << '/' << (1.0 / fpsStats.maxDt) << '/' << (1.0 / fpsStats.minDt));
+        if (++count == 3000) {
+            std::stringstream report;
+            frameStats.report(report);
+            LOGI("Frame stats:\n" << report.str());
             count = 0;
-            fpsStats.reset(t);
         }
     }
 #endif
@@ -822,7 +829,6 @@ void Game::render() {
 }
 
 void Game::resetTime() {
-    fpsStats.reset(TimeUtil::GetTime());
     lastUpdateTime = TimeUtil::GetTime();
 }
 
@@ -26,6 +26,8 @@
 #include "GameContext.h"
 #include "base/Entity.h"
 #include "util/Tuning.h"
+#include "base/SystemScheduler.h"
+#include "base/FrameStats.h"
 
 class AssetApi;
 class ComponentSystem;
@@ -33,10 +35,6 @@ class ComponentSystem;
 class MouseNativeTouchState;
 #endif
 
-#if SAC_DEBUG
-#define FPS_DEBUG_N 120
-#endif
-
 #if SAC_INGAME_EDITORS
 
 class LevelEditor;
@@ -97,22 +95,16 @@ class Game {
     Tuning tuning;
 
     bool isFinished;
-
-    struct {
-        float minDt, maxDt;
-        float since;
-        int frameCount;
-        void reset(float timeMark) {
-            minDt = 10000000;
-            maxDt = 0;
-            since = timeMark;
-            frameCount = 0;
-        }
-#if SAC_DEBUG
-        Entity square[FPS_DEBUG_N];
-        Entity text[FPS_DEBUG_N];
-#endif
-    } fpsStats;
+    // step() simulates exactly one targetDT without waiting for the wall
+    // clock and does not produce any rendering frame
+    bool fastForward;
+
+    // When late, step() runs several updates to catch up: at most this
+    // many (0: no limit). The remaining late time is dropped, so the game
+    // slows down instead of spiraling on slow devices.
+    unsigned maxUpdatesPerStep;
+    // per frame update/render/wait durations
+    FrameStats frameStats;
     float lastUpdateTime;
 #if SAC_INGAME_EDITORS
     GameType::Enum gameType;
@@ -123,6 +115,8 @@ class Game {
 
     public:
     std::vector<ComponentSystem*> orderedSystemsToUpdate;
+    // updates orderedSystemsToUpdate, concurrently when possible
+    SystemScheduler systemScheduler;
 
 #if SAC_ENABLE_LOG
     std::set<ComponentSystem*> unusedSystems;
@@ -0,0 +1,267 @@
+/*
+    This file is part of Soupe Au Caillou.
+
+    @author Soupe au Caillou - Jordane Pelloux-Prayer
+    @author Soupe au Caillou - Gautier Pelloux-Prayer
+    @author Soupe au Caillou - Pierre-Eric Pelloux-Prayer
+
+    Soupe Au Caillou is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3.
+
+    Soupe Au Caillou is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Soupe Au Caillou.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "JobSystem.h"
+#include "base/Log.h"
+#include <algorithm>
+
+// queue used by the calling thread: workers have their own one
+static thread_local const JobSystem* currentOwner = 0;
+static thread_local unsigned currentQueue = 0;
+
+JobSystem::JobSystem()
+#if !SAC_EMSCRIPTEN
+    : queued(0), quit(false), waiters(0)
+#endif
+{
+    queues.push_back(new Queue());
+}
+
+JobSystem::~JobSystem() {
+    setWorkerCount(0);
+    for (auto* q: queues) {
+        LOGW_IF(!q->jobs.empty(), q->jobs.size() << " job(s) were never run");
+        delete q;
+    }
+}
+
+JobSystem& JobSystem::Instance() {
+    static JobSystem _instance;
+    return _instance;
+}
+
+void JobSystem::run(const std::function<void()>& fn, Counter* counter, Counter* after) {
+    if (counter)
+        counter->pending++;
+
+    Job job;
+    job.fn = fn;
+    job.counter = counter;
+
+    if (after) {
+        std::lock_guard<std::mutex> lock(after->mutex);
+        if (after->pending.load() > 0) {
+            // queued by the last job 'after' is waiting for
+            after->continuations.push_back(std::make_pair(job.fn, job.counter));
+            return;
+        }
+    }
+    push(job);
+}
+
+void JobSystem::push(Job& job) {
+    Queue& q = *queues[currentOwner == this ? currentQueue : 0];
+    {
+        std::lock_guard<std::mutex> lock(q.mutex);
+        q.jobs.push_back(Job());
+        std::swap(q.jobs.back(), job);
+#if !SAC_EMSCRIPTEN
+        queued++;
+#endif
+    }
+#if !SAC_EMSCRIPTEN
+    if (!workers.empty()) {
+        // taking the lock makes sure a worker about to sleep sees 'queued'
+        { std::lock_guard<std::mutex> lock(sleepMutex); }
+        wakeUp.notify_one();
+    }
+    notifyWaiters();
+#endif
+}
+
+bool JobSystem::tryRunOne() {
+    const unsigned count = queues.size();
+    const unsigned own = (currentOwner == this) ? currentQueue : 0;
+
+    Job job;
+    bool found = false;
+    for (unsigned i=0; i<count && !found; i++) {
+        Queue& q = *queues[(own + i) % count];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if (q.jobs.empty())
+            continue;
+        if (i == 0) {
+            // own queue: latest job first
+            std::swap(job, q.jobs.back());
+            q.jobs.pop_back();
+        } else {
+            // steal the oldest one
+            std::swap(job, q.jobs.front());
+            q.jobs.pop_front();
+        }
+#if !SAC_EMSCRIPTEN
+        queued--;
+#endif
+        found = true;
+    }
+    if (found)
+        execute(job);
+    return found;
+}
+
+void JobSystem::execute(Job& job) {
+    job.fn();
+    finish(job.counter);
+}
+
+void JobSystem::finish(Counter* counter) {
+    if (!counter)
+        return;
+
+    std::vector<std::pair<std::function<void()>, Counter*> > ready;
+    bool last;
+    {
+        // decrement under the lock: wait() takes it before returning, so the
+        // counter can't be destroyed while we're still using it
+        std::lock_guard<std::mutex> lock(counter->mutex);
+        last = (--counter->pending == 0);
+        if (last)
+            ready.swap(counter->continuations);
+    }
+#if !SAC_EMSCRIPTEN
+    if (last)
+        notifyWaiters();
+#endif
+    for (auto& r: ready) {
+        Job job;
+        job.fn.swap(r.first);
+        job.counter = r.second;
+        push(job);
+    }
+}
+
+void JobSystem::wait(Counter& counter) {
+    unsigned idle = 0;
+    while (!counter.done()) {
+        if (tryRunOne()) {
+            idle = 0;
+            continue;
+        }
+#if SAC_EMSCRIPTEN
+        LOGF("Waiting for a job which will never be queued");
+#else
+        // jobs usually come back quickly: spin a bit before sleeping
+        if (++idle < 64) {
+            std::this_thread::yield();
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        waiters++;
+        progress.wait(lock, [this, &counter] () {
+            return counter.done() || queued.load() > 0;
+        });
+        waiters--;
+        idle = 0;
+#endif
+    }
+    std::lock_guard<std::mutex> lock(counter.mutex);
+}
+
+#if !SAC_EMSCRIPTEN
+void JobSystem::notifyWaiters() {
+    // waiters count themselves before checking their condition, so either
+    // they see the change or they're seen here
+    if (waiters.load() == 0)
+        return;
+    { std::lock_guard<std::mutex> lock(sleepMutex); }
+    progress.notify_all();
+}
+#endif
+
+void JobSystem::parallelFor(unsigned begin, unsigned end, unsigned grain,
+    const std::function<void(unsigned, unsigned)>& fn) {
+    if (grain == 0)
+        grain = 1;
+    if (getWorkerCount() == 0 || end - begin <= grain) {
+        for (unsigned first = begin; first < end; first += grain) {
+            fn(first, std::min(first + grain, end));
+        }
+        return;
+    }
+
+    Counter counter;
+    // the first range is kept for the calling thread
+    for (unsigned first = begin + grain; first < end; first += grain) {
+        const unsigned last = std::min(first + grain, end);
+        run([&fn, first, last] () { fn(first, last); }, &counter);
+    }
+    fn(begin, begin + grain);
+    wait(counter);
+}
+
+#if SAC_EMSCRIPTEN
+void JobSystem::setWorkerCount(unsigned) {}
+
+unsigned JobSystem::getWorkerCount() const { return 0; }
+#else
+void JobSystem::setWorkerCount(unsigned count) {
+    if (count == workers.size())
+        return;
+
+    {
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        quit = true;
+    }
+    wakeUp.notify_all();
+    for (auto& th: workers) {
+        th.join();
+    }
+    workers.clear();
+    quit = false;
+
+    // jobs left in removed queues go to the shared one
+    while (queues.size() > count + 1) {
+        Queue* q = queues.back();
+        for (auto& job: q->jobs) {
+            queues[0]->jobs.push_back(Job());
+            std::swap(queues[0]->jobs.back(), job);
+        }
+        delete q;
+        queues.pop_back();
+    }
+    while (queues.size() < count + 1) {
+        queues.push_back(new Queue());
+    }
+
+    for (unsigned i=0; i<count; i++) {
+        workers.push_back(std::thread(&JobSystem::workerLoop, this, i + 1));
+    }
+    LOGI("Job system uses " << count << " worker thread(s)");
+}
+
+unsigned JobSystem::getWorkerCount() const {
+    return workers.size();
+}
+
+void JobSystem::workerLoop(unsigned index) {
+    currentOwner = this;
+    currentQueue = index;
+
+    while (true) {
+        if (tryRunOne())
+            continue;
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wakeUp.wait(lock, [this] () { return quit || queued.load() > 0; });
+        if (quit)
+            return;
+    }
+}
+#endif
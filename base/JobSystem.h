@@ -0,0 +1,130 @@
+/*
+    This file is part of Soupe Au Caillou.
+
+    @author Soupe au Caillou - Jordane Pelloux-Prayer
+    @author Soupe au Caillou - Gautier Pelloux-Prayer
+    @author Soupe au Caillou - Pierre-Eric Pelloux-Prayer
+
+    Soupe Au Caillou is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3.
+
+    Soupe Au Caillou is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Soupe Au Caillou.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+#if !SAC_EMSCRIPTEN
+#include <thread>
+#include <condition_variable>
+#endif
+
+#define theJobSystem (JobSystem::Instance())
+
+// Runs small jobs on a pool of worker threads: system updates (see
+// SystemScheduler), and ranges of entities a system splits its
+// DoUpdate into (see parallelFor).
+//
+// Each worker has its own queue: it pushes and pops jobs at the back (most
+// recent first, data is still in cache), and when it runs out of work it
+// steals the oldest jobs of the other queues. Threads outside the pool
+// (game thread) push to a shared queue, and run jobs themselves while
+// waiting for them (see wait).
+//
+// Without worker (or on emscripten), jobs are run by wait().
+class JobSystem {
+    public:
+        // Counts unfinished jobs. Jobs can be made to wait for a counter
+        // (see run), and threads can wait for it (see wait).
+        class Counter {
+            public:
+                Counter() : pending(0) {}
+                bool done() const { return pending.load() == 0; }
+
+            private:
+                friend class JobSystem;
+                Counter(const Counter&);
+                Counter& operator=(const Counter&);
+
+                std::atomic<int> pending;
+                std::mutex mutex;
+                // jobs waiting for this counter to reach 0
+                std::vector<std::pair<std::function<void()>, Counter*> > continuations;
+        };
+
+        JobSystem();
+        ~JobSystem();
+
+        static JobSystem& Instance();
+
+        // 0 worker means jobs are only run by threads waiting for them
+        void setWorkerCount(unsigned count);
+        unsigned getWorkerCount() const;
+
+        // Queues 'job'. 'counter' (optional) is incremented now and
+        // decremented once the job is done. If 'after' is given, the job is
+        // only queued once 'after' is done.
+        void run(const std::function<void()>& job, Counter* counter = 0, Counter* after = 0);
+
+        // Work done outside of jobs can be counted too: 'counter' isn't done
+        // until release is called for each hold
+        void hold(Counter& counter) { counter.pending++; }
+        void release(Counter& counter) { finish(&counter); }
+
+        // Runs queued jobs until 'counter' is done. Sleeps when there's
+        // nothing to run for a while.
+        void wait(Counter& counter);
+
+        // Calls fn(first, last) over [begin, end) split in ranges of at most
+        // 'grain' items, and returns once all of them are done. The calling
+        // thread processes ranges too.
+        void parallelFor(unsigned begin, unsigned end, unsigned grain,
+            const std::function<void(unsigned, unsigned)>& fn);
+
+    private:
+        JobSystem(const JobSystem&);
+        JobSystem& operator=(const JobSystem&);
+
+        struct Job {
+            std::function<void()> fn;
+            Counter* counter;
+        };
+        void push(Job& job);
+        bool tryRunOne();
+        void execute(Job& job);
+        void finish(Counter* counter);
+
+        struct Queue {
+            std::mutex mutex;
+            std::deque<Job> jobs;
+        };
+        // [0] is shared by threads outside the pool, [i + 1] is worker i's
+        std::vector<Queue*> queues;
+
+#if !SAC_EMSCRIPTEN
+        void workerLoop(unsigned index);
+
+        std::vector<std::thread> workers;
+        void notifyWaiters();
+
+        // idle workers sleep until a job is queued
+        std::mutex sleepMutex;
+        std::condition_variable wakeUp;
+        std::atomic<int> queued;
+        bool quit;
+        // idle wait() calls sleep until a job is queued or a counter is done
+        std::condition_variable progress;
+        std::atomic<int> waiters;
+#endif
+};
@@ -44,6 +44,10 @@ void addProfilePoint(const std::string& category, const std::string& name, enum
     LOGW("todo")
 }
 
+void addProfileCounter(const std::string& category, const std::string& name, long long value) {
+    LOGW("todo")
+}
+
 #else
 
 
@@ -88,7 +92,7 @@ static inline const char* scopeEnum2String(enum InstantScope scope) {
     }
 }
 
-void addProfilePoint(const std::string& category, const std::string& name, enum ProfilePhase ph, enum InstantScope scope/*=ThreadScope*/, int id/*=0*/) {
+static void addEvent(const std::string& category, const std::string& name, enum ProfilePhase ph, enum InstantScope scope, int id, const std::string& args) {
     if (!started)
         return;
     timespec t1;
@@ -104,7 +108,7 @@ void addProfilePoint(const std::string& category, const std::string& name, enum
     a << "\"pid\":" << pid << ",";
     a << "\"tid\":" << std::this_thread::get_id() << ",";
     a << "\"ts\":" << ts << ",";
-    a << "\"args\":{}";
+    a << "\"args\":" << args;
     if( ph == CompleteEvent )
     {
         a << ",\"dur\":" << dur;
@@ -126,6 +130,18 @@ void addProfilePoint(const std::string& category, const std::string& name, enum
     root.push_back(s);
 }
 
+void addProfilePoint(const std::string& category, const std::string& name, enum ProfilePhase ph, enum InstantScope scope/*=ThreadScope*/, int id/*=0*/) {
+    addEvent(category, name, ph, scope, id, "{}");
+}
+
+void addProfileCounter(const std::string& category, const std::string& name, long long value) {
+    if (!started)
+        return;
+    std::stringstream args;
+    args << "{\"" << name << "\":" << value << "}";
+    addEvent(category, name, CounterEvent, ThreadScope, 1, args.str());
+}
+
 void startProfiler() {
     std::unique_lock<std::mutex> lck(mutex);
     if (started)
@@ -59,9 +59,16 @@ void addProfilePoint(const std::string& category,
                      enum InstantScope scope = ThreadScope,
                      int id = 1);
 
+void addProfileCounter(const std::string& category,
+                       const std::string& name,
+                       long long value);
+
 #if SAC_ENABLE_PROFILING
 #define PROFILE(cat, name, phase)                                              \
     do { addProfilePoint(cat, name, phase, ThreadScope, 1); } while (false)
+#define PROFILE_COUNTER(cat, name, value)                                      \
+    do { addProfileCounter(cat, name, value); } while (false)
 #else
 #define PROFILE(cat, name, phase)
+#define PROFILE_COUNTER(cat, name, value)
 #endif
@@ -0,0 +1,201 @@
+/*
+    This file is part of Soupe Au Caillou.
+
+    @author Soupe au Caillou - Jordane Pelloux-Prayer
+    @author Soupe au Caillou - Gautier Pelloux-Prayer
+    @author Soupe au Caillou - Pierre-Eric Pelloux-Prayer
+
+    Soupe Au Caillou is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3.
+
+    Soupe Au Caillou is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Soupe Au Caillou.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "SystemScheduler.h"
+#include "systems/System.h"
+#include "base/Log.h"
+#include "util/Tuning.h"
+#include <algorithm>
+#include <cmath>
+
+static bool intersects(const std::vector<hash_t>& a, const std::vector<hash_t>& b) {
+    for (auto h: a) {
+        if (std::find(b.begin(), b.end(), h) != b.end())
+            return true;
+    }
+    return false;
+}
+
+bool SystemScheduler::conflict(const ComponentSystem* a, const ComponentSystem* b) {
+    if (!a->hasDeclaredAccesses() || !b->hasDeclaredAccesses())
+        return true;
+    return intersects(a->getWrites(), b->getWrites()) ||
+        intersects(a->getWrites(), b->getReads()) ||
+        intersects(b->getWrites(), a->getReads());
+}
+
+SystemScheduler::SystemScheduler(JobSystem& jobs) : updateCount(0), tuningVersion(~0u), jobs(jobs) {
+}
+
+void SystemScheduler::build(const std::vector<ComponentSystem*>& orderedSystems) {
+    const unsigned count = orderedSystems.size();
+    nodes.clear();
+    nodes.resize(count);
+    done.reset(new JobSystem::Counter[count]);
+    gates.reset(new JobSystem::Counter[count]);
+
+    // reachable[i][j]: j must be done before i starts
+    std::vector<std::vector<bool> > reachable(count, std::vector<bool>(count, false));
+
+    for (unsigned i=0; i<count; i++) {
+        Node& node = nodes[i];
+        node.system = orderedSystems[i];
+        node.elapsed = 0;
+        node.due = node.exclusive = false;
+        node.after = 0;
+
+        // walk previous systems from the closest one, and skip those
+        // already (indirectly) depended on
+        for (int j=(int)i - 1; j>=0; j--) {
+            if (reachable[i][j] || !conflict(orderedSystems[j], orderedSystems[i]))
+                continue;
+            node.predecessors.push_back(j);
+            reachable[i][j] = true;
+            for (unsigned k=0; k<(unsigned)j; k++) {
+                if (reachable[j][k]) reachable[i][k] = true;
+            }
+        }
+        std::reverse(node.predecessors.begin(), node.predecessors.end());
+
+        LOGV(2, INV_HASH(node.system->getId()) << "System depends on " << node.predecessors.size() << " system(s)");
+    }
+    // new systems may have settings
+    tuningVersion = ~0u;
+}
+
+void SystemScheduler::configure(const Tuning& tuning, float updateDuration) {
+    // (version 0: nothing loaded yet)
+    if (tuning.version() == tuningVersion || tuning.version() == 0)
+        return;
+    tuningVersion = tuning.version();
+
+    unsigned lowRateCount = 0;
+    for (auto& node: nodes) {
+        ComponentSystem* system = node.system;
+        const hash_t section = system->getId();
+
+        ComponentSystem::UpdatePolicy policy;
+        const float rate = tuning.f(section, HASH("update_rate", 0x812793f8), 0);
+        if (rate > 0) {
+            policy.period = std::max(1l, std::lround(1 / (rate * updateDuration)));
+        }
+        if (policy.period > 1) {
+            policy.phase = lowRateCount++ % policy.period;
+        }
+        policy.budget = std::max(0, tuning.i(section, HASH("update_budget", 0x54a087a0), 0));
+        system->setUpdatePolicy(policy);
+
+        LOGI_IF(policy.period > 1 || policy.budget, INV_HASH(section) << "System updated every "
+            << policy.period << " update(s) (phase: " << policy.phase << "), budget: " << policy.budget);
+    }
+}
+
+bool SystemScheduler::startUpdate(float dt) {
+    bool any = false;
+    for (auto& node: nodes) {
+        const ComponentSystem::UpdatePolicy& policy = node.system->getUpdatePolicy();
+        node.elapsed += dt;
+        node.due = (updateCount % policy.period) == policy.phase;
+        any |= node.due;
+    }
+    updateCount++;
+    return any;
+}
+
+void SystemScheduler::updateSystem(unsigned index) {
+    Node& node = nodes[index];
+    node.system->Update(node.elapsed);
+    node.elapsed = 0;
+}
+
+static void joined() {}
+
+// counter done once the nodes 'index' depends on are, and the last exclusive
+// one ('barrier', if any)
+JobSystem::Counter* SystemScheduler::gate(unsigned index, int barrier) {
+    const std::vector<unsigned>& predecessors = nodes[index].predecessors;
+    const unsigned count = predecessors.size() + (barrier >= 0 ? 1 : 0);
+    if (count == 0)
+        return 0;
+    if (count == 1)
+        return &done[barrier >= 0 ? barrier : predecessors[0]];
+
+    // joined by empty jobs, each one queued once one of them is done
+    JobSystem::Counter* g = &gates[index];
+    for (auto p: predecessors) {
+        jobs.run(joined, g, &done[p]);
+    }
+    if (barrier >= 0)
+        jobs.run(joined, g, &done[barrier]);
+    return g;
+}
+
+void SystemScheduler::update(float dt) {
+    if (!startUpdate(dt))
+        return;
+    if (jobs.getWorkerCount() == 0) {
+        for (unsigned i=0; i<nodes.size(); i++) {
+            if (nodes[i].due)
+                updateSystem(i);
+        }
+        return;
+    }
+
+    // queue every node now: jobs start as soon as their gate is done. Nodes
+    // for the calling thread hold their counter until it updated them, and
+    // an exclusive node is a barrier for all the following ones.
+    callerNodes.clear();
+    int barrier = -1;
+    for (unsigned i=0; i<nodes.size(); i++) {
+        Node& node = nodes[i];
+        node.exclusive = node.due && node.system->needsExclusiveUpdate();
+        if (node.exclusive || (node.due && node.system->updatesOnGameThreadOnly())) {
+            jobs.hold(done[i]);
+            callerNodes.push_back(i);
+            // (exclusive nodes wait for all the previous ones instead)
+            node.after = node.exclusive ? 0 : gate(i, barrier);
+        } else {
+            jobs.run([this, i] () {
+                if (nodes[i].due)
+                    updateSystem(i);
+            }, &done[i], gate(i, barrier));
+        }
+        if (node.exclusive)
+            barrier = i;
+    }
+
+    // nodes for the calling thread only depend on previous ones: waiting for
+    // them in order can't block. Waiting runs other jobs meanwhile.
+    for (auto index: callerNodes) {
+        const Node& node = nodes[index];
+        if (node.exclusive) {
+            for (unsigned i=0; i<index; i++) {
+                jobs.wait(done[i]);
+            }
+        } else if (node.after) {
+            jobs.wait(*node.after);
+        }
+        updateSystem(index);
+        jobs.release(done[index]);
+    }
+    for (unsigned i=0; i<nodes.size(); i++) {
+        jobs.wait(done[i]);
+    }
+}
@@ -0,0 +1,90 @@
+/*
+    This file is part of Soupe Au Caillou.
+
+    @author Soupe au Caillou - Jordane Pelloux-Prayer
+    @author Soupe au Caillou - Gautier Pelloux-Prayer
+    @author Soupe au Caillou - Pierre-Eric Pelloux-Prayer
+
+    Soupe Au Caillou is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3.
+
+    Soupe Au Caillou is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Soupe Au Caillou.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "base/JobSystem.h"
+
+#include <memory>
+#include <vector>
+
+class ComponentSystem;
+class Tuning;
+
+// Updates systems using their declared accesses (see
+// ComponentSystem::declareAccesses): two systems conflict if one writes
+// components the other one reads or writes, and conflicting systems are
+// updated in the order they were given in. Other systems are run as jobs
+// (see JobSystem) as soon as the ones they depend on are done.
+//
+// Systems updating on the game thread only, or needing an exclusive update,
+// are updated by the calling thread, in order. Nothing else runs during an
+// exclusive update.
+class SystemScheduler {
+    public:
+    SystemScheduler(JobSystem& jobs = JobSystem::Instance());
+
+    // (re)build the dependency graph. Systems are listed in update order
+    void build(const std::vector<ComponentSystem*>& orderedSystems);
+
+    // Applies update policies (see ComponentSystem::UpdatePolicy) read from
+    // the [<system name>] sections of 'tuning', when its values changed:
+    //   update_rate = 10   (in Hz, every game update if missing)
+    //   update_budget = 50 (entities per update, time-sliced systems only)
+    // Low rate systems are given different phases, so they don't all run
+    // during the same game update.
+    void configure(const Tuning& tuning, float updateDuration);
+
+    // Returns once all systems due this update have been updated. Without
+    // job system worker, they're updated sequentially on the calling thread.
+    void update(float dt);
+
+    // systems (index in the build() list) that must be done before
+    // 'index' can start. Only direct dependencies are kept.
+    const std::vector<unsigned>& dependencies(unsigned index) const { return nodes[index].predecessors; }
+
+    static bool conflict(const ComponentSystem* a, const ComponentSystem* b);
+
+    private:
+    struct Node {
+        ComponentSystem* system;
+        std::vector<unsigned> predecessors;
+        // time since the last update of the system
+        float elapsed;
+        bool due, exclusive;
+        // (nodes updated by the calling thread) what to wait for first
+        JobSystem::Counter* after;
+    };
+    std::vector<Node> nodes;
+    unsigned updateCount;
+    // tuning values used by configure, ~0 if never applied
+    unsigned tuningVersion;
+
+    bool startUpdate(float dt);
+    void updateSystem(unsigned index);
+    JobSystem::Counter* gate(unsigned index, int barrier);
+
+    JobSystem& jobs;
+    // per node: done once the system is updated (or skipped), and once the
+    // nodes it waits for are done, when there are several of them
+    std::unique_ptr<JobSystem::Counter[]> done, gates;
+    // nodes updated by the calling thread during the current update
+    std::vector<unsigned> callerNodes;
+};
@@ -67,6 +67,10 @@ static void adjustTransformWithAnchor(TransformationComponent* tc,
 
 #if SAC_DEBUG
 void Delete(Entity e) override;
+// keep the per-entity parenting check
+void DeleteMany(const Entity* e, unsigned count) override {
+    for (unsigned i = 0; i < count; i++) Delete(e[i]);
+}
 #endif
 }
 ;
@@ -37,6 +37,7 @@ static void applyFrameToEntity(Entity e, const AnimationComponent*, const AnimDe
 INSTANCE_IMPL(AnimationSystem);
 
 AnimationSystem::AnimationSystem() : ComponentSystemImpl<AnimationComponent>(HASH("Animation", 0x3050a3d5)) {
+    declareAccesses({}, { HASH("Rendering", 0xe6cc1e11) });
     AnimationComponent tc;
     componentSerializer.add(new Property<hash_t>(HASH("name", 0x195267c7), OFFSET(name, tc)));
     componentSerializer.add(new Property<float>(HASH("playback_speed", 0xe564d97a), OFFSET(playbackSpeed, tc), 0.001f));
@@ -45,7 +45,6 @@ AutoDestroySystem::AutoDestroySystem() : ComponentSystemImpl<AutoDestroyComponen
 }
 
 void AutoDestroySystem::DoUpdate(float dt) {
-    std::vector<std::pair<Entity, bool> > toRemove;
     FOR_EACH_ENTITY_COMPONENT(AutoDestroy, a, adc)
         switch (adc->type) {
             case AutoDestroyComponent::OUT_OF_AREA: {
@@ -55,7 +54,7 @@ void AutoDestroySystem::DoUpdate(float dt) {
                     adc->params.area.position, adc->params.area.size, 0)) {
 
                     if (!adc->dontDestroy) {
-                        toRemove.push_back(std::make_pair(a, adc->hasText));
+                        theEntityManager.deferred.DeleteEntity(a);
 
                         LOGV(1, "Entity " << theEntityManager.entityName(a) << " is out of area -> destroyed ("
                             << tc->position << " not in " << adc->params.area.position << " x " << adc->params.area.position + adc->params.area.size);
@@ -67,7 +66,7 @@ void AutoDestroySystem::DoUpdate(float dt) {
                 adc->params.lifetime.freq.accum += dt;
                 if (adc->params.lifetime.freq.accum >= adc->params.lifetime.freq.value) {
                     if (!adc->dontDestroy) {
-                        toRemove.push_back(std::make_pair(a, adc->hasText));
+                        theEntityManager.deferred.DeleteEntity(a);
                         LOGV(1, "Entity " << theEntityManager.entityName(a) << " lifetime is over -> destroyed");
                     } else {
                         adc->params.lifetime.freq.accum = adc->params.lifetime.freq.value;
@@ -87,21 +86,4 @@ void AutoDestroySystem::DoUpdate(float dt) {
             }
         }
     END_FOR_EACH()
-    const size_t s = toRemove.size();
-    for (unsigned i=0; i<s; i++) {
-        const std::pair<Entity, bool>& p = toRemove[i];
-
-        #if 0
-        if (AUTO_DESTROY(p.first)->onDeletionCall) {
-            LOGI("Calling onDeletionCall function for " << theEntityManager.entityName(p.first));
-            AUTO_DESTROY(p.first)->onDeletionCall(p.first);
-        }
-        #endif
-
-        if (p.second) {
-            theEntityManager.DeleteEntity(p.first);
-        } else {
-            theEntityManager.DeleteEntity(p.first);
-        }
-    }
 }
@@ -70,6 +70,9 @@ AutonomousAgentSystem::AutonomousAgentSystem() : ComponentSystemImpl<AutonomousA
     EXPORT_BEHAVIOR_PARAM(separation, 0xe6642c0, 0xb6ca78ed);
     EXPORT_BEHAVIOR_PARAM(cohesion, 0x60651d29, 0x624454d6);
 #endif
+    // agents are steered independently: spreading them over several
+    // updates is fine
+    enableTimeSlicing();
 }
 
 bool AutonomousAgentSystem::isArrived(Entity ) {
@@ -80,7 +83,7 @@ void AutonomousAgentSystem::DoUpdate(float dt) {
 #if SAC_DEBUG
     Draw::Clear(HASH("aa", 0x6e1cb412));
 #endif
-    FOR_EACH_ENTITY_COMPONENT(AutonomousAgent, e, agent)
+    FOR_EACH_ENTITY_COMPONENT_SLICED(AutonomousAgent, e, agent)
         Steering::Context interest, priority, danger;
         memset(&interest, 0, sizeof(Steering::Context));
         memset(&priority, 0, sizeof(Steering::Context));
@@ -26,14 +26,25 @@
 
 INSTANCE_IMPL(BackInTimeSystem);
 
-BackInTimeSystem::BackInTimeSystem() : ComponentSystemImpl<BackInTimeComponent>(HASH("BackInTime", 0x7c9eb7e5)) {
+BackInTimeSystem::BackInTimeSystem() : ComponentSystemImpl<BackInTimeComponent>(HASH("BackInTime", 0x7c9eb7e5), ComponentType::POD, 8, ComponentStorage::Soa) {
+    declareAccesses({ HASH("Transformation", 0x4d33e992) }, {});
+    soaField(&BackInTimeComponent::position);
+    soaField(&BackInTimeComponent::size);
+    soaField(&BackInTimeComponent::rotation);
 }
 
 void BackInTimeSystem::DoUpdate(float) {
-    FOR_EACH_ENTITY_COMPONENT(BackInTime, e, comp)
-        const auto* tc = TRANSFORM(e);
-        comp->position = tc->position;
-        comp->size = tc->size;
-        comp->rotation = tc->rotation;
+    // every component is copied: transforms are also written through held
+    // pointers and a stale copy would break swept collisions and interpolation
+    glm::vec2* position = column(&BackInTimeComponent::position);
+    glm::vec2* size = column(&BackInTimeComponent::size);
+    float* rotation = column(&BackInTimeComponent::rotation);
+    for (uint32_t i = 0; i < entityWithComponent.size(); i++) {
+        const TransformationComponent* tc = theTransformationSystem.tryRead(entityWithComponent[i]);
+        if (tc) {
+            position[i] = tc->position;
+            size[i] = tc->size;
+            rotation[i] = tc->rotation;
+        }
     }
 }
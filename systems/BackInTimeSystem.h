@@ -24,6 +24,8 @@
 
 #include "System.h"
 
+// Stored as columns (see ComponentStorage::Soa): use theBackInTimeSystem.read
+// or column instead of pointers
 struct BackInTimeComponent {
     BackInTimeComponent()
         : position(0.0f), size(1.0f), rotation(0) {}
@@ -34,11 +36,6 @@ struct BackInTimeComponent {
 };
 
 #define theBackInTimeSystem BackInTimeSystem::GetInstance()
-#if SAC_DEBUG
-#define BACK_IN_TIME(e) theBackInTimeSystem.Get(e, true, __FILE__, __LINE__)
-#else
-#define BACK_IN_TIME(e) theBackInTimeSystem.Get(e)
-#endif
 
 UPDATABLE_SYSTEM(BackInTime)
 };
@@ -28,6 +28,7 @@
 INSTANCE_IMPL(BlinkSystem);
 
 BlinkSystem::BlinkSystem() : ComponentSystemImpl<BlinkComponent>(HASH("Blink", 0x5fd02ba7)) {
+    declareAccesses({}, { HASH("Rendering", 0xe6cc1e11), HASH("Text", 0x5763c1af) });
     BlinkComponent tc;
     componentSerializer.add(new Property<bool>(HASH("enabled", 0x1d6995b7), OFFSET(enabled, tc)));
     componentSerializer.add(new Property<float>(HASH("visible_duration", 0x40000832), OFFSET(visibleDuration, tc), 0.001f));
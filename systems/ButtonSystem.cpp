@@ -37,7 +37,7 @@
 
 INSTANCE_IMPL(ButtonSystem);
 
-ButtonSystem::ButtonSystem() : ComponentSystemImpl<ButtonComponent>(HASH("Button", 0x47dde38d)) {
+ButtonSystem::ButtonSystem() : ComponentSystemImpl<ButtonComponent>(HASH("Button", 0x47dde38d), ComponentType::POD, 8, ComponentStorage::Sparse) {
     /* nothing saved */
     vibrateAPI = 0;
 
@@ -27,7 +27,8 @@
 
 INSTANCE_IMPL(CameraSystem);
 
-CameraSystem::CameraSystem() : ComponentSystemImpl<CameraComponent>(HASH("Camera", 0x83d48114)) {
+CameraSystem::CameraSystem() : ComponentSystemImpl<CameraComponent>(HASH("Camera", 0x83d48114), ComponentType::POD, 8, ComponentStorage::Sparse) {
+    declareAccesses({}, {});
     CameraComponent tc;
     componentSerializer.add(new Property<bool>(HASH("enable", 0x5d70851c), OFFSET(enable, tc)));
     componentSerializer.add(new Property<bool>(HASH("clear", 0xd676a285), OFFSET(clear, tc)));
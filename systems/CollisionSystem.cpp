@@ -43,6 +43,7 @@ INSTANCE_IMPL(CollisionSystem);
 #define MAX_COLLISION_COUNT_PER_ENTITY 4
 
 CollisionSystem::CollisionSystem() : ComponentSystemImpl<CollisionComponent>(HASH("Collision", 0x638cf8ed)) {
+    declareAccesses({ HASH("BackInTime", 0x7c9eb7e5), HASH("SpatialPartition", 0x35df9814) }, { HASH("Transformation", 0x4d33e992) });
     CollisionComponent tc;
     componentSerializer.add(new Property<int>(HASH("group", 0xbf3bf34d), OFFSET(group, tc), 0));
     componentSerializer.add(new Property<int>(HASH("collide_with", 0x6b658240), OFFSET(collideWith, tc), 0));
@@ -69,12 +70,14 @@ struct EntityData {
     int group;
     int collideWith;
     AABB aabb;
+    // BackInTime components are stored as columns: copied once per update
+    BackInTimeComponent back;
 };
 
 struct Cell {
     Cell() : collidingGroups(0) {}
 
-    std::vector<EntityData> entities;
+    FrameVector<EntityData> entities;
 
     int collidingGroups;
 
@@ -103,8 +106,8 @@ struct TransformInterpolation {
 };
 
 static bool determineCollisionTimestamp(EntityData e1, EntityData e2, float* timeBefore, float* timeAt) {
-    TransformInterpolation ti1(TRANSFORM(e1.e), BACK_IN_TIME(e1.e));
-    TransformInterpolation ti2(TRANSFORM(e2.e), BACK_IN_TIME(e2.e));
+    TransformInterpolation ti1(TRANSFORM(e1.e), &e1.back);
+    TransformInterpolation ti2(TRANSFORM(e2.e), &e2.back);
 
     float tNope = 0.0f;
     float tYes = FLT_MAX;
@@ -188,7 +191,7 @@ static char debugText[8096];
 void CollisionSystem::DoUpdate(float dt) {
 
     // int minCollidingEntity = INT_MAX, maxCollidingEntity = 0;
-    std::vector<Cell> cells;
+    FrameVector<Cell> cells;
     int gridPitch = theSpatialPartitionSystem.gridSize.x;
     cells.resize(gridPitch * theSpatialPartitionSystem.gridSize.y);
     int collidingEntitiesCount = 0;
@@ -208,25 +211,28 @@ void CollisionSystem::DoUpdate(float dt) {
         if (sp->count == 0) {
             continue;
         }
+        // same data in every cell
+        EntityData d;
+        d.e = entity;
+        const bool found = theBackInTimeSystem.read(entity, d.back);
+        LOGF_IF(!found, "Entity '" << theEntityManager.entityName(entity) << "' has no BackInTime component");
+        AABB nowBefore[2];
+        IntersectionUtil::computeAABB(
+            TRANSFORM(entity),
+            nowBefore[0]);
+        IntersectionUtil::computeAABB(
+            d.back.position,
+            d.back.size,
+            d.back.rotation,
+            nowBefore[1]);
+        d.aabb = IntersectionUtil::mergeAABB(nowBefore, 2);
+        d.group = cc->group;
+        d.collideWith = cc->collideWith;
+
         const auto* spCells = theSpatialPartitionSystem.getCells(sp->cellOffset);
         for (int i=0; i<sp->count; i++) {
             glm::ivec2 coords = spCells[i];
             Cell& cell = cells[gridPitch * coords.y + coords.x];
-            const auto* hc = BACK_IN_TIME(entity);
-            EntityData d;
-            d.e = entity;
-            AABB nowBefore[2];
-            IntersectionUtil::computeAABB(
-                TRANSFORM(entity),
-                nowBefore[0]);
-            IntersectionUtil::computeAABB(
-                hc->position,
-                hc->size,
-                hc->rotation,
-                nowBefore[1]);
-            d.aabb = IntersectionUtil::mergeAABB(nowBefore, 2);
-            d.group = cc->group;
-            d.collideWith = cc->collideWith;
             cell.entities.push_back(d);
             if (cc->collideWith > 0) {
                 cell.collidingGroups |= cc->group;
@@ -317,10 +323,10 @@ void CollisionSystem::DoUpdate(float dt) {
                                 float ts = cc->restoreTransformation.atCollision ?
                                     tAt : tBefore;
                                 auto* tc = TRANSFORM(reference.e);
-                                auto* bc = BACK_IN_TIME(reference.e);
-                                tc->position = glm::lerp(bc->position, tc->position, ts);
-                                tc->size = glm::lerp(bc->size, tc->size, ts);
-                                tc->rotation = glm::lerp(bc->rotation, tc->rotation, ts);
+                                const auto& bc = reference.back;
+                                tc->position = glm::lerp(bc.position, tc->position, ts);
+                                tc->size = glm::lerp(bc.size, tc->size, ts);
+                                tc->rotation = glm::lerp(bc.rotation, tc->rotation, ts);
                             }
                         }
 
@@ -334,10 +340,10 @@ void CollisionSystem::DoUpdate(float dt) {
                                 float ts = cc->restoreTransformation.atCollision ?
                                     tAt : tBefore;
                                 auto* tc = TRANSFORM(test.e);
-                                auto* bc = BACK_IN_TIME(test.e);
-                                tc->position = glm::lerp(bc->position, tc->position, ts);
-                                tc->size = glm::lerp(bc->size, tc->size, ts);
-                                tc->rotation = glm::lerp(bc->rotation, tc->rotation, ts);
+                                const auto& bc = test.back;
+                                tc->position = glm::lerp(bc.position, tc->position, ts);
+                                tc->size = glm::lerp(bc.size, tc->size, ts);
+                                tc->rotation = glm::lerp(bc.rotation, tc->rotation, ts);
                             }
                         }
                     }
@@ -82,6 +82,9 @@ static glm::vec2 collisionPointToNormal(const glm::vec2& point,
                                         const TransformationComponent* tc);
 
 #if SAC_DEBUG
+// debug drawing creates entities
+bool needsExclusiveUpdate() const override { return showDebug; }
+
 bool showDebug;
 int maximumRayCastPerSec;
 float maximumRayCastPerSecAccum;
@@ -146,7 +146,7 @@ void NetworkSystem::DoUpdate(float dt) {
                     LOGV(1, "Received DELETE_ENTITY msg (guid: " << header->entityGuid << ")");
                     Entity e = guidToEntity(header->entityGuid);
                     if (e) {
-                        theEntityManager.DeleteEntity(e);
+                        theEntityManager.deferred.DeleteEntity(e);
                     } else {
                         LOGE("Unable to find entity to delete");
                     }
@@ -422,14 +422,16 @@ bool NetworkSystem::isOwnedLocally(Entity e) {
 }
 
 void NetworkSystem::deleteAllNonLocalEntities() {
-    int count = 0;
+    // not called during systems update: delete right away, in one batch
+    // (collected first, as deleting changes entityWithComponent)
+    FrameVector<Entity> remote;
     FOR_EACH_ENTITY_COMPONENT(Network, e, nc)
         if (!(nc->guid & GUID_TAG)) {
-            theEntityManager.DeleteEntity(e);
-            count++;
+            remote.push_back(e);
         }
     END_FOR_EACH()
-    LOGI("Removed " << count << " non local entities");
+    theEntityManager.DeleteEntities(remote.data(), remote.size());
+    LOGI("Removed " << remote.size() << " non local entities");
 }
 
 unsigned int NetworkSystem::entityToGuid(Entity e) {
@@ -51,6 +51,9 @@ unsigned int entityToGuid(Entity e);
 Entity guidToEntity(unsigned int guid);
 
 void Delete(Entity e) override;
+void DeleteMany(const Entity* e, unsigned count) override {
+    for (unsigned i = 0; i < count; i++) Delete(e[i]);
+}
 
 bool isOwnedLocally(Entity e);
 
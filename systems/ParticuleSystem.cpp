@@ -24,6 +24,7 @@
 #include "TransformationSystem.h"
 #include "PhysicsSystem.h"
 #include "base/EntityManager.h"
+#include "base/FrameArena.h"
 #include "BackInTimeSystem.h"
 #include <glm/glm.hpp>
 #include <glm/gtx/rotate_vector.hpp>
@@ -37,7 +38,7 @@
 
 INSTANCE_IMPL(ParticuleSystem);
 
-ParticuleSystem::ParticuleSystem() : ComponentSystemImpl<ParticuleComponent>(HASH("Particule", 0x52ec2829)) {
+ParticuleSystem::ParticuleSystem() : ComponentSystemImpl<ParticuleComponent>(HASH("Particule", 0x52ec2829), ComponentType::POD, 8, ComponentStorage::Sparse) {
     /* nothing saved */
     minUsedIdx = maxUsedIdx = 0;
 
@@ -66,7 +67,7 @@ static void updateInternal(InternalParticule internal, float t) {
 }
 
 void ParticuleSystem::DoUpdate(float dt) {
-    std::vector<Entity> recyclable;
+    FrameVector<Entity> recyclable;
 
     // update emitted particules
     {
@@ -134,23 +135,45 @@ void ParticuleSystem::DoUpdate(float dt) {
 
         particules.resize(particules.size() + spawnCount);
 
-        // recycle particule entities
-        for (int i=0; i<(int)spawnCount && i<recyclableCount; i++) {
-            particules[firstParticuleIndex + i].e = recyclable[i];
+        // recycle particule entities: dead ones first, then pooled ones
+        int reused = 0;
+        for (; reused<(int)spawnCount && reused<recyclableCount; reused++) {
+            particules[firstParticuleIndex + reused].e = recyclable[reused];
+        }
+        while (reused<(int)spawnCount && !pool.empty()) {
+            const Entity e = pool.back();
+            pool.pop_back();
+            if (theEntityManager.isAlive(e)) {
+                particules[firstParticuleIndex + reused++].e = e;
+            }
         }
         // create missing particules
-        for (int i=recyclableCount; i<(int)spawnCount; i++) {
-            Entity e = theEntityManager.CreateEntity(HASH("__/particule", 0xe08bc21));
-            ADD_COMPONENT(e, Transformation);
-            ADD_COMPONENT(e, Rendering);
-            ADD_COMPONENT(e, Physics);
-            particules[firstParticuleIndex + i].e = e;
+        const int missingCount = (int)spawnCount - reused;
+        if (missingCount > 0) {
+            FrameVector<Entity> created(missingCount);
+            theEntityManager.CreateEntities(missingCount, created.data(), HASH("__/particule", 0xe08bc21));
+            theEntityManager.AddComponentToEntities(created.data(), missingCount,
+                { &theTransformationSystem, &theRenderingSystem, &thePhysicsSystem });
+            for (int i=0; i<missingCount; i++) {
+                particules[firstParticuleIndex + reused + i].e = created[i];
+            }
         }
     }
-    // last but not least, delete unused recyclable particules
-    auto& mgr = theEntityManager;
+    // last but not least, hide unused recyclable particules: they'll absorb
+    // the next spawn count variations without creating/deleting entities
     for (int i=(int)spawnCount; i<recyclableCount; i++) {
-        mgr.DeleteEntity(recyclable[i]);
+        const Entity e = recyclable[i];
+        RENDERING(e)->show = false;
+        PhysicsComponent* ppc = PHYSICS(e);
+        ppc->mass = 0;
+        ppc->forces.clear();
+        pool.push_back(e);
+    }
+    // but don't keep more of them than live particules
+    while (pool.size() > particules.size()) {
+        if (theEntityManager.isAlive(pool.back()))
+            theEntityManager.deferred.DeleteEntity(pool.back());
+        pool.pop_back();
     }
 
     if (spawnCount == 0.0f)
@@ -166,14 +189,14 @@ void ParticuleSystem::DoUpdate(float dt) {
 
         glm::vec2 position = ptc->position;
         glm::vec2 size = ptc->size;
-        const auto* back = theBackInTimeSystem.Get(a, false);
-        if (back) {
-            position = (ptc->position + back->position) * 0.5f;
-            size += glm::rotate(ptc->position - back->position, -ptc->rotation);
+        BackInTimeComponent back;
+        if (theBackInTimeSystem.read(a, back)) {
+            position = (ptc->position + back.position) * 0.5f;
+            size += glm::rotate(ptc->position - back.position, -ptc->rotation);
         }
 
 
-        float* randoms = new float[added * 3];
+        float* randoms = FrameArena::current().allocate<float>(added * 3);
         Random::N_Floats(added, randoms, -0.5f * size.x, 0.5f * size.x);
         Random::N_Floats(added, &randoms[added], -0.5f * size.y, 0.5f * size.y);
         Random::N_Floats(added, &randoms[2 * added], 0, dt);
@@ -75,6 +75,7 @@ UPDATABLE_SYSTEM(Particule)
 private:
 std::vector<InternalParticule> particules;
 int minUsedIdx, maxUsedIdx;
+// hidden particule entities, reused before creating new ones
 std::vector<Entity> pool;
 int poolLastValidElement;
 }
@@ -34,6 +34,7 @@
 INSTANCE_IMPL(PhysicsSystem);
 
 PhysicsSystem::PhysicsSystem() : ComponentSystemImpl<PhysicsComponent>(HASH("Physics", 0xecfc0aba), ComponentType::Complex) {
+    declareAccesses({ HASH("Anchor", 0xf220ebf3) }, { HASH("Transformation", 0x4d33e992) });
     PhysicsComponent tc;
     componentSerializer.add(new Property<glm::vec2>(HASH("linear_velocity", 0xba5da842), OFFSET(linearVelocity, tc), glm::vec2(0.001f, 0)));
     componentSerializer.add(new Property<float>(HASH("angular_velocity", 0x9d13e5d2), OFFSET(angularVelocity, tc), 0.001f));
@@ -44,16 +45,18 @@ PhysicsSystem::PhysicsSystem() : ComponentSystemImpl<PhysicsComponent>(HASH("Phy
 }
 
 void PhysicsSystem::DoUpdate(float dt) {
-    FOR_EACH_ENTITY_COMPONENT(Physics, a, pc)
+    View<PhysicsComponent, TransformationComponent> view(*this, theTransformationSystem);
+    for (const auto& row: view) {
+        PhysicsComponent* pc = row.get<0>();
         // no mass -> no physics
         if (pc->mass <= 0)
             continue;
 
 #if SAC_DEBUG
-        auto anchor = theAnchorSystem.Get(a, false);
+        auto anchor = theAnchorSystem.Get(row.entity, false);
         if (anchor && anchor->parent) {
             LOGW("Entity '"
-                << theEntityManager.entityName(a)
+                << theEntityManager.entityName(row.entity)
                 << "' tried to do physics while being anchored to '"
                 << theEntityManager.entityName(anchor->parent)
                 << "'");
@@ -104,8 +107,7 @@ void PhysicsSystem::DoUpdate(float dt) {
             }
         }
 
-        TransformationComponent* tc = TRANSFORM(a);
-
+        TransformationComponent* tc = row.get<1>();
 
         tc->position += (pc->linearVelocity + nextVelocity) * dt * 0.5f;
         // velocity varies over dt: use Verlet integration for position
@@ -123,7 +125,7 @@ void PhysicsSystem::DoUpdate(float dt) {
                 tc->rotation = glm::atan(nextVelocity.y, nextVelocity.x);
             }
         }
-    END_FOR_EACH()
+    }
 }
 
 
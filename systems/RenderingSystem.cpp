@@ -24,17 +24,24 @@
 #include "RenderingSystem_Private.h"
 
 #include "base/EntityManager.h"
+#include "base/FrameArena.h"
+#include "base/JobSystem.h"
 
 #include "TransformationSystem.h"
 #include "CameraSystem.h"
+#include "BackInTimeSystem.h"
 
 #include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <cstddef>
+#include <cstring>
 #include <sstream>
 #include <glm/glm.hpp>
 #include <glm/gtx/rotate_vector.hpp>
 
 #include "util/IntersectionUtil.h"
+#include "util/RadixSort.h"
 #include "opengl/OpenGLTextureCreator.h"
 
 #if SAC_DEBUG
@@ -56,13 +63,15 @@
 
 INSTANCE_IMPL(RenderingSystem);
 
-RenderingSystem::RenderingSystem() : ComponentSystemImpl<RenderingComponent>(HASH("Rendering", 0xe6cc1e11), ComponentType::POD, 128), assetAPI(0), initDone(false) {
+RenderingSystem::RenderingSystem() : ComponentSystemImpl<RenderingComponent>(HASH("Rendering", 0xe6cc1e11), ComponentType::POD, 128), assetAPI(0), headless(false), pipelined(false), initDone(false) {
     nextValidFBRef = 1;
-    currentWriteQueue = 0;
     frameQueueWritable = false;
-    newFrameReady = false;
+    writeQueue = 0;
+    readQueue = 1;
+    handoff = 2;
+    droppedFrames = reusedFrames = 0;
 #if ! SAC_EMSCRIPTEN
-    mutexes = new std::mutex[3];
+    mutexes = new std::mutex[2];
     cond = new std::condition_variable[2];
 #endif
 
@@ -76,7 +85,7 @@ RenderingSystem::RenderingSystem() : ComponentSystemImpl<RenderingComponent>(HAS
     InternalTexture::Invalid.color = InternalTexture::Invalid.alpha = 0;
     initDone = true;
 
-    renderQueue = new RenderQueue[2];
+    renderQueue = new RenderQueue[3];
 
 #if SAC_INGAME_EDITORS
     memset(&highLight, 0, sizeof(highLight));
@@ -87,6 +96,12 @@ RenderingSystem::RenderingSystem() : ComponentSystemImpl<RenderingComponent>(HAS
     indices = new unsigned short[MAX_INDICE_COUNT];
 
     nextConstantOffset = 0;
+
+    cullingCellSize = cullingGrid.getCellSize();
+    cullingVersion = 0;
+    cullingStats.visited = cullingStats.culled = 0;
+    visibilityCamera = 0;
+    visibilityCameraVersion = 0;
 }
 
 RenderingSystem::~RenderingSystem() {
@@ -106,7 +121,9 @@ void RenderingSystem::setWindowSize(int width, int height, float sW, float sH) {
     windowH = height;
     screenW = sW;
     screenH = sH;
-    GL_OPERATION(glViewport(0, 0, windowW, windowH))
+    if (!headless) {
+        GL_OPERATION(glViewport(0, 0, windowW, windowH))
+    }
 }
 
 void RenderingSystem::setWindowSize(const glm::vec2& windowSize, const glm::vec2& screenSize) {
@@ -114,12 +131,13 @@ void RenderingSystem::setWindowSize(const glm::vec2& windowSize, const glm::vec2
     windowH = windowSize.y;
     screenW = screenSize.x;
     screenH = screenSize.y;
-    GL_OPERATION(glViewport(0, 0, windowW, windowH))
+    if (!headless) {
+        GL_OPERATION(glViewport(0, 0, windowW, windowH))
+    }
 }
 
 void RenderingSystem::init() {
     LOGF_IF(!assetAPI, "AssetAPI must be set before init is called");
-    OpenGLTextureCreator::detectSupportedTextureFormat();
     textureLibrary.init(assetAPI);
     effectLibrary.init(assetAPI);
 
@@ -128,6 +146,11 @@ void RenderingSystem::init() {
     defaultShaderEmpty = effectLibrary.load(EMPTY_FRAGMENT);
     defaultShaderNoTexture = effectLibrary.load(DEFAULT_NO_TEXTURE_FRAGMENT);
 
+    if (headless)
+        return;
+
+    OpenGLTextureCreator::detectSupportedTextureFormat();
+
     // create 1px white texture
     uint8_t data[] = {255, 255, 255, 255};
     GL_OPERATION(glGenTextures(1, &whiteTexture))
@@ -204,13 +227,16 @@ void RenderingSystem::init() {
 #endif
 }
 
+// rows of the Rendering/Transformation view handled by each DoUpdate job
+static const unsigned RowsPerJob = 256;
+
 // [z][flags][effect][texture][color]
 //   flags:      3 bits
 //  effect:      8 bits
 // atlasIndex:     8 bits
 //   color:     32 bits
 //   z:         4 bits
-static uint64_t makeKeyOpaque(const RenderingSystem::RenderCommand& rc) {
+static uint64_t makeKeyOpaque(const RenderingSystem::RenderCommand& rc, int atlasIndex) {
     uint64_t key = 0;
 
     // end goal is to sort object by key
@@ -220,7 +246,7 @@ static uint64_t makeKeyOpaque(const RenderingSystem::RenderCommand& rc) {
     // z:       60...53
     key |= (((uint64_t)rc.effectRef) & 0xFF) << 52;
     // texture: 52...45
-    key |= ((uint64_t)rc.atlasIndex & 0xFF) << 44;
+    key |= ((uint64_t)atlasIndex & 0xFF) << 44;
     // color:   44...12
     uint64_t color = rc.color.asInt();
     key |= (0xEFFFFFFF & (color >> 1) << 12);
@@ -239,7 +265,7 @@ static uint64_t makeKeyOpaque(const RenderingSystem::RenderCommand& rc) {
 //  effect:      8 bits
 // texture:      8 bits
 //   color:     32 bits
-static uint64_t makeKeyBlended(const RenderingSystem::RenderCommand& rc) {
+static uint64_t makeKeyBlended(const RenderingSystem::RenderCommand& rc, int atlasIndex) {
     uint64_t key = 0;
 
     // z:       63...48
@@ -250,7 +276,7 @@ static uint64_t makeKeyBlended(const RenderingSystem::RenderCommand& rc) {
     // effect:  47..40
     key |= (((uint64_t)rc.effectRef) & 0xFF) << 40;
     // texture: 39...32
-    key |= ((uint64_t)(rc.atlasIndex & 0xFF)) << 32;
+    key |= ((uint64_t)(atlasIndex & 0xFF)) << 32;
     key |= ((uint64_t)((rc.rflags & RenderingFlags::Constant) >> 3) << 31);
      // /* color:   30...00 */
     uint64_t color = rc.color.asInt();
@@ -259,18 +285,6 @@ static uint64_t makeKeyBlended(const RenderingSystem::RenderCommand& rc) {
     return key;
 }
 
-// This function is used to sort opaque sprites from front to back
-// Note: the sort algorithm sort from min to max, so in this case, r1 < r2
-// means r1.z > r2.z
-static bool sortFrontToBack(const RenderingSystem::RenderCommand& r1, const RenderingSystem::RenderCommand& r2) {
-    return r1.key > r2.key;
-}
-
-// This function is used to sort alpha-blended sprites from back to front.
-static bool sortBackToFront(const RenderingSystem::RenderCommand& r1, const RenderingSystem::RenderCommand& r2) {
-    return r1.key < r2.key;
-}
-
 static inline void modifyQ(RenderingSystem::RenderCommand& r, const glm::vec2& offsetPos, const glm::vec2& size) {
     const glm::vec2 offset =  offsetPos * r.halfSize * 2.0f + size * r.halfSize * 2.0f * 0.5f;
     r.position = r.position  + glm::vec2((r.rflags & RenderingFlags::MirrorHorizontal ? -1.0f : 1.0f), 1.0f) * glm::rotate(- r.halfSize + offset, r.rotation);
@@ -287,6 +301,47 @@ static void modifyR(RenderingSystem::RenderCommand& r, const glm::vec2& offsetPo
     r.uv[1] = size;
 }
 
+static inline void motionDuringLastStep(bool enabled, Entity e, const TransformationComponent* tc, RenderingSystem::RenderCommand& c) {
+    c.positionDelta = glm::vec2(0.0f);
+    c.rotationDelta = 0;
+    if (!enabled)
+        return;
+    // BackInTime holds the state from before the last simulation step
+    BackInTimeComponent back;
+    if (theBackInTimeSystem.read(e, back)) {
+        c.positionDelta = tc->position - back.position;
+        c.rotationDelta = tc->rotation - back.rotation;
+    }
+}
+
+// Bounds used by the culling grid: contain the ones DoUpdate tests, with or
+// without FastCulling (Rendering flags aren't tracked)
+static inline AABB cullingBounds(const TransformationComponent* tc) {
+    AABB rotated, result;
+    IntersectionUtil::computeAABB(tc, rotated, true);
+    const glm::vec2 halfSize = tc->size * 0.5f;
+    result.left = glm::min(rotated.left, tc->position.x - halfSize.x);
+    result.right = glm::max(rotated.right, tc->position.x + halfSize.x);
+    result.bottom = glm::min(rotated.bottom, tc->position.y - halfSize.y);
+    result.top = glm::max(rotated.top, tc->position.y + halfSize.y);
+    return result;
+}
+
+// What DoUpdate gathers for each camera: the commands of visible rows are
+// shared, every camera gets the keys of the ones it draws
+struct CameraBin {
+    const CameraComponent* comp;
+    const TransformationComponent* trans;
+    AABB aabb;
+    float invSize;
+    // slots of visible rows, packed once all jobs are done
+    SortKey* opaqueKeys;
+    SortKey* blendedKeys;
+    // keys written by each job
+    unsigned* opaqueCounts;
+    unsigned* blendedCounts;
+};
+
 #if 0
 static bool cull(const TransformationComponent* camera, RenderingSystem::RenderCommand& c) {
     if (c.rotation == 0 && c.halfSize.x > 0) {
@@ -337,7 +392,7 @@ void RenderingSystem::updateReload() {
     textureLibrary.updateReload();
 }
 
-void RenderingSystem::DoUpdate(float LOG_USAGE_ONLY(dt)) {
+void RenderingSystem::DoUpdate(float dt) {
     updateReload();
 
 #else
@@ -347,65 +402,188 @@ void RenderingSystem::DoUpdate(float dt) {
 #if SAC_DEBUG
     static unsigned int cccc = 0;
 #endif
-    RenderQueue& outQueue = renderQueue[currentWriteQueue];
-
-    LOGV(3, "UPDATE #" << currentWriteQueue << '/' << cccc << ',' << __(dt));
+    RenderQueue& outQueue = renderQueue[writeQueue];
 
-#if SAC_DEBUG
-    LOGV_IF(1, outQueue.count != 0, "Non empty queue : " << outQueue.count << " (queue=" << currentWriteQueue << ')');
-#endif
+    LOGV(3, "UPDATE #" << writeQueue << '/' << cccc << ',' << __(dt));
 
     // retrieve all cameras
-    auto cameras = theCameraSystem.RetrieveAllEntityWithComponent();
+    const auto& allCameras = theCameraSystem.RetrieveAllEntityWithComponent();
+    FrameVector<Entity> cameras(allCameras.begin(), allCameras.end());
     // remove non active ones
     std::remove_if(cameras.begin(), cameras.end(), CameraSystem::isDisabled);
     // sort along order
     std::sort(cameras.begin(), cameras.end(), CameraSystem::sort);
 
-    // alloca here is dangerous
-    RenderCommand* opaqueCommands = (RenderCommand*) malloc(entityCount() * sizeof(RenderCommand));
-    RenderCommand* blendedCommands = (RenderCommand*) malloc(entityCount() * sizeof(RenderCommand));
-
-    unsigned opaqueIndex = 0, blendedIndex = 0;
-    outQueue.count = 0;
-    for (auto camera: cameras) {
-        const CameraComponent* camComp = CAMERA(camera);
-        const TransformationComponent* camTrans = TRANSFORM(camera);
+    visibilityCamera = 0;
+    for (auto cam: allCameras) {
+        if (theCameraSystem.tryRead(cam)->fb == DefaultFrameBufferRef) {
+            visibilityCamera = cam;
+            break;
+        }
+    }
+    visibilityCameraVersion = ComponentSystem::CurrentVersion();
 
-        const float cameraInvSize = 1.0f / (camTrans->size.x * camTrans->size.y);
-        opaqueIndex = blendedIndex = 0;
+    // alloca here is dangerous
+    RenderCommand* opaqueCommands = FrameArena::current().allocate<RenderCommand>(entityCount());
+    RenderCommand* blendedCommands = FrameArena::current().allocate<RenderCommand>(entityCount());
+    // keys are sorted instead of the commands themselves (radixSort needs a
+    // temp array)
+    SortKey* sortTmp = FrameArena::current().allocate<SortKey>(entityCount());
+
+    // join rendering and transformation once, for all cameras
+    View<RenderingComponent, const TransformationComponent> view(*this, theTransformationSystem);
+
+    // read once: may be toggled from another thread
+    const bool withMotion = pipelined;
+
+    // constant sprites get their place in the static buffer before jobs
+    // start, so offsets don't depend on job scheduling
+    for (const auto& row: view) {
+        RenderingComponent* rc = row.get<0>();
+        if (rc->show && (rc->flags & RenderingFlags::Constant) && rc->indiceOffset == 0) {
+            rc->indiceOffset = nextConstantOffset;
+            nextConstantOffset += theTransformationSystem.shapes[row.get<1>()->shape].vertices.size() * 2;
+            // (the render thread uploads its vertices on first sight)
+        }
+    }
 
-        AABB camAABB;
-        IntersectionUtil::computeAABB(camTrans, camAABB);
+    // keep the culling grid in sync with the rows: it is only rebuilt when
+    // its cell size changes, otherwise new rows are inserted, moved ones
+    // updated and the ones which left removed
+    const unsigned rowCount = view.size();
+    const uint32_t since = cullingVersion;
+    cullingVersion = ComponentSystem::CurrentVersion();
+    if (cullingCellSize != cullingGrid.getCellSize())
+        cullingGrid.reset(cullingCellSize);
+
+    uint32_t idCount = 0;
+    for (const auto& row: view) {
+        idCount = glm::max(idCount, EntityHandle::index(row.entity) + 1);
+    }
+    // entity index -> row + 1 (0: not a row)
+    uint32_t* rowOf = FrameArena::current().allocate<uint32_t>(idCount);
+    std::fill(rowOf, rowOf + idCount, 0);
+    if (cullingInputs.size() < idCount)
+        cullingInputs.resize(idCount);
+    for (unsigned r=0; r<rowCount; r++) {
+        const uint32_t id = EntityHandle::index(view[r].entity);
+        rowOf[id] = r + 1;
+        // transforms are compared with the ones the grid saw, rather than
+        // relying on change stamps: they're also written through held
+        // pointers (morphs, editors...) which don't stamp anything
+        const TransformationComponent* tc = view[r].get<1>();
+        CullingInput& input = cullingInputs[id];
+        static_assert(sizeof(CullingInput) == offsetof(TransformationComponent, z),
+            "CullingInput must match the start of TransformationComponent");
+        if (memcmp(&input, &tc->position, sizeof(input)) || !cullingGrid.contains(id)) {
+            memcpy(&input, &tc->position, sizeof(input));
+            cullingGrid.update(id, cullingBounds(tc));
+        }
+    }
+    // rows can only have left if components were removed since last update
+    if (membershipVersion() >= since || theTransformationSystem.membershipVersion() >= since) {
+        for (uint32_t id=0; id<cullingInputs.size(); id++) {
+            if ((id >= idCount || !rowOf[id]) && cullingGrid.contains(id))
+                cullingGrid.remove(id);
+        }
+    }
+    // a row's mask tells which cameras the grid found it near (bit i is
+    // cameras[i]), so each camera only costs its visible rows
+    const unsigned cameraCount = cameras.size();
+    LOGF_IF(cameraCount > 32, "Too many active cameras: " << cameraCount);
+    CameraBin* bins = FrameArena::current().allocate<CameraBin>(cameraCount);
+    uint32_t* rowCameras = FrameArena::current().allocate<uint32_t>(rowCount);
+    std::fill(rowCameras, rowCameras + rowCount, 0);
+    cullingStats.visited = cullingStats.culled = 0;
+    for (unsigned i=0; i<cameraCount; i++) {
+        CameraBin& bin = bins[i];
+        bin.comp = CAMERA(cameras[i]);
+        bin.trans = TRANSFORM(cameras[i]);
+        bin.invSize = 1.0f / (bin.trans->size.x * bin.trans->size.y);
+        IntersectionUtil::computeAABB(bin.trans, bin.aabb);
+
+        cullingCandidates.clear();
+        cullingGrid.query(bin.aabb, cullingCandidates);
+        unsigned near = 0;
+        for (uint32_t id: cullingCandidates) {
+            if (id < idCount && rowOf[id]) {
+                rowCameras[rowOf[id] - 1] |= 1u << i;
+                near++;
+            }
+        }
+        cullingStats.visited += near;
+        cullingStats.culled += rowCount - near;
+    }
 
-        /* render */
-        FOR_EACH_ENTITY_COMPONENT(Rendering, a, rc)
-            bool ccc = rc->cameraBitMask & (0x1 << camComp->id);
-            if (!rc->show || rc->color.a <= 0 || !ccc ) {
+    // rows near at least one camera, in row order (same output as visiting all)
+    FrameVector<uint32_t> visibleRows;
+    visibleRows.reserve(rowCount);
+    for (unsigned r=0; r<rowCount; r++) {
+        if (rowCameras[r])
+            visibleRows.push_back(r);
+    }
+    const unsigned visibleCount = visibleRows.size();
+
+    // Each visible row gives at most 1 opaque and 1 blended command, whatever
+    // the number of cameras drawing it, so jobs write them (and the cameras'
+    // keys) in the slots of their rows; keys are packed once all jobs are done.
+    const unsigned jobCount = (visibleCount + RowsPerJob - 1) / RowsPerJob;
+    for (unsigned i=0; i<cameraCount; i++) {
+        bins[i].opaqueKeys = FrameArena::current().allocate<SortKey>(visibleCount);
+        bins[i].blendedKeys = FrameArena::current().allocate<SortKey>(visibleCount);
+        bins[i].opaqueCounts = FrameArena::current().allocate<unsigned>(jobCount);
+        bins[i].blendedCounts = FrameArena::current().allocate<unsigned>(jobCount);
+    }
+    std::mutex missingAtlasesMutex;
+    std::vector<int> missingAtlases;
+
+    /* render: ranges of rows are processed in parallel */
+    auto generateRange = [&] (unsigned first, unsigned last) {
+        // next key slot of each camera
+        unsigned opaqueIndex[32], blendedIndex[32];
+        std::fill(opaqueIndex, opaqueIndex + cameraCount, first);
+        std::fill(blendedIndex, blendedIndex + cameraCount, first);
+        // consecutive sprites often share their texture
+        TextureRef cachedTexture = InvalidTextureRef;
+        const TextureInfo* cachedInfo = 0;
+
+        for (unsigned r=first; r<last; r++) {
+            const auto& row = view[visibleRows[r]];
+            RenderingComponent* rc = row.get<0>();
+            if (!rc->show || rc->color.a <= 0) {
                 continue;
             }
 
-            const TransformationComponent* tc = TRANSFORM(a);
+            const TransformationComponent* tc = row.get<1>();
 
-            if (rc->flags & RenderingFlags::NoCulling) {
-                if (!IntersectionUtil::pointRectangleAABB(tc->position, camAABB)) {
-                    continue;
-                }
-            } else {
-                AABB entityAABB;
+            // cameras drawing this row
+            const bool noCulling = rc->flags & RenderingFlags::NoCulling;
+            AABB entityAABB;
+            if (!noCulling)
                 IntersectionUtil::computeAABB(tc, entityAABB, !(rc->flags & RenderingFlags::FastCulling));
-
-                if (!IntersectionUtil::rectangleRectangleAABB(camAABB, entityAABB)) {
+            uint32_t drawn = 0;
+            const uint32_t near = rowCameras[visibleRows[r]];
+            for (unsigned i=0; i<cameraCount; i++) {
+                if (!(near & (1u << i)) || !(rc->cameraBitMask & (0x1 << bins[i].comp->id)))
                     continue;
+                if (noCulling ?
+                    IntersectionUtil::pointRectangleAABB(tc->position, bins[i].aabb) :
+                    IntersectionUtil::rectangleRectangleAABB(bins[i].aabb, entityAABB)) {
+                    drawn |= 1u << i;
                 }
             }
+            if (!drawn) {
+                continue;
+            }
 
-            LOGW_IF(tc->z <= 0 || tc->z > 1, "Entity '" << theEntityManager.entityName(a) <<
+            LOGW_IF(tc->z <= 0 || tc->z > 1, "Entity '" << theEntityManager.entityName(row.entity) <<
                 "' has invalid z value: " << tc->z << ". Will not be drawn");
 
             RenderCommand c;
             c.z = tc->z;
-            c.texture = c.atlasIndex = rc->texture;
+            c.texture = rc->texture;
+            // only used by sort keys
+            int atlasIndex = rc->texture;
             c.effectRef = rc->effectRef;
             c.halfSize = tc->size * 0.5f;
             c.color = rc->color;
@@ -418,20 +596,16 @@ void RenderingSystem::DoUpdate(float dt) {
             }
 #endif
 
-            c.shapeType = (int)tc->shape;
+            c.shapeType = tc->shape;
             c.position = tc->position;
             c.rotation = tc->rotation;
+            motionDuringLastStep(withMotion, row.entity, tc, c);
             c.rflags = rc->flags;
-            if ((rc->flags & RenderingFlags::Constant) && rc->indiceOffset == 0) {
-                rc->indiceOffset = nextConstantOffset;
-                nextConstantOffset += theTransformationSystem.shapes[tc->shape].vertices.size() * 2;
-                c.rflags |= RenderingFlags::ConstantNeedsUpdate;
-            }
             c.indiceOffset = rc->indiceOffset;
             c.uv[0] = glm::vec2(0.0f);
             c.uv[1] = glm::vec2(1.0f);
 #if SAC_DEBUG
-            c.e = a;
+            c.e = row.entity;
 #endif
 
             if (c.rflags & RenderingFlags::ZPrePass) {
@@ -464,14 +638,20 @@ void RenderingSystem::DoUpdate(float dt) {
             if (c.rflags & RenderingFlags::Constant)
                 c.flags |= EnableConstantBit;
 
+            // area of the full-opaque block added at the center, if any
+            float centerArea = 0;
             if (c.texture != InvalidTextureRef && !(c.rflags & RenderingFlags::TextureIsFBO)) {
-                const TextureInfo* info = textureLibrary.get(c.texture, false);
+                if (c.texture != cachedTexture) {
+                    cachedTexture = c.texture;
+                    cachedInfo = textureLibrary.get(c.texture, false);
+                }
+                const TextureInfo* info = cachedInfo;
                 if (info) {
-                    int atlasIdx = c.atlasIndex = info->atlasIndex;
-                    // If atlas texture is not loaded yet, load it
+                    int atlasIdx = atlasIndex = info->atlasIndex;
+                    // If atlas texture is not loaded yet, load it (see below)
                     if (atlasIdx >= 0 && atlas[atlasIdx].ref == InvalidTextureRef) {
-                        atlas[atlasIdx].ref = textureLibrary.load(atlas[atlasIdx].name.c_str());
-                        LOGV(1, "Requested effective load of atlas '" << atlas[atlasIdx].name << "' -> ref=" << atlas[atlasIdx].ref);
+                        std::lock_guard<std::mutex> lock(missingAtlasesMutex);
+                        missingAtlases.push_back(atlasIdx);
                     }
 
                     // Only display the required area of the texture
@@ -482,14 +662,16 @@ void RenderingSystem::DoUpdate(float dt) {
                     // 2. alpha == 1
                     // 3. non empty opaque area
                     // 4. sprite is not a z prepass one
-                    // 5. sprite cover at least 1.25% of the camera source area
+                    // 5. sprite cover at least 1.25% of the camera source area (checked per camera)
                     if (c.rflags & RenderingFlags::NonOpaque &&
                         c.color.a >= 1 &&
                         info->opaqueSize != glm::vec2(0.0f) &&
-                        !(c.rflags & RenderingFlags::ZPrePass) &&
-                        ((c.halfSize.x * info->opaqueSize.x) * (c.halfSize.y * info->opaqueSize.y) * cameraInvSize) > 0.001) {
+                        !(c.rflags & RenderingFlags::ZPrePass)) {
+                        centerArea = (c.halfSize.x * info->opaqueSize.x) * (c.halfSize.y * info->opaqueSize.y);
+
                         // add a smaller full-opaque block at the center
-                        RenderCommand cCenter(c);
+                        RenderCommand& cCenter = opaqueCommands[r];
+                        cCenter = c;
 #if SAC_INGAME_EDITORS
                         cCenter.color = rc->color;
                         if (highLight.runtimeOpaque) {
@@ -506,21 +688,6 @@ void RenderingSystem::DoUpdate(float dt) {
                             cCenter.indiceOffset = c.indiceOffset + theTransformationSystem.shapes[tc->shape].vertices.size();
                             cCenter.flags |= EnableConstantBit;
                         }
-
-                        if (1 /*cull(camTrans, cCenter)*/) {
-                            cCenter.key = makeKeyOpaque(cCenter);
-                            opaqueCommands[opaqueIndex++] = cCenter;
-                        }
-
-#if SAC_INGAME_EDITORS
-                        if (highLight.nonOpaque) {
-                            c.color.b = 0.f;
-                            c.color.a *= 0.6f;
-                        }
-#endif
-                        c.key = makeKeyBlended(c);
-                        blendedCommands[blendedIndex++] = c;
-                        continue;
                     }
                 }
             }
@@ -533,42 +700,101 @@ void RenderingSystem::DoUpdate(float dt) {
                 #endif
              }
 
-            if (c.rflags & RenderingFlags::NonOpaque) {
+            // opaque sprites are drawn front to back: decreasing keys
+            const bool blended = c.rflags & RenderingFlags::NonOpaque;
+            uint64_t key, centerKey = 0;
+            if (blended) {
 #if SAC_INGAME_EDITORS
                 if (highLight.nonOpaque) {
                     c.color.b = 0.f;
                     c.color.a *= 0.6f;
                 }
 #endif
-                c.key = makeKeyBlended(c);
-                blendedCommands[blendedIndex++] = c;
+                key = makeKeyBlended(c, atlasIndex);
+                blendedCommands[r] = c;
+                if (centerArea > 0)
+                    centerKey = ~makeKeyOpaque(opaqueCommands[r], atlasIndex);
             } else {
-                c.key = makeKeyOpaque(c);
-                opaqueCommands[opaqueIndex++] = c;
+                key = ~makeKeyOpaque(c, atlasIndex);
+                opaqueCommands[r] = c;
             }
-        END_FOR_EACH()
 
-        unsigned cnt = outQueue.count + opaqueIndex + blendedIndex + 1;
+            for (unsigned i=0; i<cameraCount; i++) {
+                if (!(drawn & (1u << i)))
+                    continue;
+                CameraBin& bin = bins[i];
+                if (centerArea * bin.invSize > 0.001) {
+                    bin.opaqueKeys[opaqueIndex[i]].key = centerKey;
+                    bin.opaqueKeys[opaqueIndex[i]++].index = r;
+                }
+                if (blended) {
+                    bin.blendedKeys[blendedIndex[i]].key = key;
+                    bin.blendedKeys[blendedIndex[i]++].index = r;
+                } else {
+                    bin.opaqueKeys[opaqueIndex[i]].key = key;
+                    bin.opaqueKeys[opaqueIndex[i]++].index = r;
+                }
+            }
+        }
+        for (unsigned i=0; i<cameraCount; i++) {
+            bins[i].opaqueCounts[first / RowsPerJob] = opaqueIndex[i] - first;
+            bins[i].blendedCounts[first / RowsPerJob] = blendedIndex[i] - first;
+        }
+    };
+    // (by reference: the closure is too big to be copied in a
+    // std::function without allocating)
+    theJobSystem.parallelFor(0, visibleCount, RowsPerJob, std::cref(generateRange));
+
+    // atlases used for the first time (not loaded by jobs: the library
+    // isn't meant to be modified concurrently)
+    std::sort(missingAtlases.begin(), missingAtlases.end());
+    for (int atlasIdx: missingAtlases) {
+        if (atlas[atlasIdx].ref == InvalidTextureRef) {
+            atlas[atlasIdx].ref = textureLibrary.load(atlas[atlasIdx].name.c_str());
+            LOGV(1, "Requested effective load of atlas '" << atlas[atlasIdx].name << "' -> ref=" << atlas[atlasIdx].ref);
+        }
+    }
+
+    outQueue.count = 0;
+    for (unsigned i=0; i<cameraCount; i++) {
+        CameraBin& bin = bins[i];
+
+        // pack keys in row order: same output as a sequential loop
+        unsigned opaqueCount = 0, blendedCount = 0;
+        for (unsigned j=0; j<jobCount; j++) {
+            std::copy(bin.opaqueKeys + j * RowsPerJob, bin.opaqueKeys + j * RowsPerJob + bin.opaqueCounts[j], bin.opaqueKeys + opaqueCount);
+            opaqueCount += bin.opaqueCounts[j];
+            std::copy(bin.blendedKeys + j * RowsPerJob, bin.blendedKeys + j * RowsPerJob + bin.blendedCounts[j], bin.blendedKeys + blendedCount);
+            blendedCount += bin.blendedCounts[j];
+        }
+
+        unsigned cnt = outQueue.count + opaqueCount + blendedCount + 1;
 
         if (outQueue.commands.size() < cnt)
             outQueue.commands.resize(cnt);
 
-        std::sort(opaqueCommands, opaqueCommands + opaqueIndex, sortFrontToBack);
-        std::sort(blendedCommands, blendedCommands + blendedIndex, sortBackToFront);
+        // opaque: front to back, blended: back to front
+        radixSort(bin.opaqueKeys, sortTmp, opaqueCount);
+        radixSort(bin.blendedKeys, sortTmp, blendedCount);
 
         RenderCommand dummy;
         dummy.texture = BeginFrameMarker;
 #if SAC_DEBUG
         dummy.e = 0;
 #endif
-        packCameraAttributes(camTrans, camComp, dummy);
+        packCameraAttributes(bin.trans, bin.comp, dummy);
+        motionDuringLastStep(withMotion, cameras[i], bin.trans, dummy);
         outQueue.commands[outQueue.count] = dummy;
         outQueue.count++;
-        std::copy(opaqueCommands, opaqueCommands + opaqueIndex, outQueue.commands.begin() + outQueue.count);
-        outQueue.count += opaqueIndex;
-        std::copy(blendedCommands, blendedCommands + blendedIndex, outQueue.commands.begin() + outQueue.count);
-        outQueue.count += blendedIndex;
+        for (unsigned k=0; k<opaqueCount; k++) {
+            outQueue.commands[outQueue.count++] = opaqueCommands[bin.opaqueKeys[k].index];
+        }
+        for (unsigned k=0; k<blendedCount; k++) {
+            outQueue.commands[outQueue.count++] = blendedCommands[bin.blendedKeys[k].index];
+        }
     }
+    PROFILE_COUNTER("Renderer", "culling-visited", cullingStats.visited);
+    PROFILE_COUNTER("Renderer", "culling-culled", cullingStats.culled);
 
 #if SAC_DEBUG
     float invSize = 400.0f / (theRenderingSystem.screenW * theRenderingSystem.screenH);
@@ -593,16 +819,10 @@ void RenderingSystem::DoUpdate(float dt) {
     );
 #endif
 
-    free (opaqueCommands);
-    free (blendedCommands);
-
     outQueue.commands.reserve(outQueue.count + 1);
 
     RenderCommand dummy;
     dummy.texture = EndFrameMarker;
-#if SAC_DEBUG
-    dummy.atlasIndex = cccc;
-#endif
     if (outQueue.commands.size() <= outQueue.count)
         outQueue.commands.push_back(dummy);
     else
@@ -611,9 +831,11 @@ void RenderingSystem::DoUpdate(float dt) {
 
     // outQueue.count++;
 #if SAC_DEBUG
+#if SAC_ENABLE_PROFILING
     std::stringstream framename;
     framename << "create-frame-" << cccc;
     PROFILE("Render", framename.str(), InstantEvent);
+#endif
     cccc++;
 #endif
 
@@ -624,45 +846,71 @@ void RenderingSystem::DoUpdate(float dt) {
     editor->newFrame(&outQueue.commands[0], outQueue.count);
 #endif
 
+    outQueue.timestamp = TimeUtil::GetTime();
+    outQueue.step = dt;
+
+    publishFrame();
+}
+
+void RenderingSystem::publishFrame() {
+    // hand the frame over, and get the spare queue back to write the next one
+    const int previous = handoff.exchange(writeQueue | NewFrameBit);
+    writeQueue = previous & QueueIndexMask;
 #if ! SAC_EMSCRIPTEN
-    // Lock to not change queue while ther thread is reading it
-    mutexes[L_RENDER].lock();
-    // Lock for notifying queue change
-    mutexes[L_QUEUE].lock();
-#endif
-    currentWriteQueue = (currentWriteQueue + 1) % 2;
-    LOGV(3, "DONE. Next write queue: " << currentWriteQueue);
-    newFrameReady = true;
+    notifyHandoff(C_FRAME_READY);
+#endif
+    if (previous & NewFrameBit) {
+        LOGV(2, "Previous frame was not rendered, dropping it");
+        droppedFrames++;
+        PROFILE_COUNTER("Renderer", "dropped-frames", droppedFrames);
+    }
+    LOGV(3, "DONE. Next write queue: " << writeQueue);
+}
+
+bool RenderingSystem::acquireLatestFrame(float timeout) {
 #if ! SAC_EMSCRIPTEN
-    cond[C_FRAME_READY].notify_all();
-    mutexes[L_QUEUE].unlock();
-    mutexes[L_RENDER].unlock();
+    if (timeout > 0 && !(handoff & NewFrameBit)) {
+        std::unique_lock<std::mutex> lock(mutexes[L_FRAME]);
+        cond[C_FRAME_READY].wait_for(lock, std::chrono::duration<float>(timeout), [this] () {
+            return (handoff & NewFrameBit) || !frameQueueWritable;
+        });
+    }
 #endif
+    if (!(handoff & NewFrameBit)) {
+        if (renderQueue[readQueue].count) {
+            reusedFrames++;
+            PROFILE_COUNTER("Renderer", "reused-frames", reusedFrames);
+        }
+        return false;
+    }
+    // the game thread may publish in between: still the latest frame
+    readQueue = handoff.exchange(readQueue) & QueueIndexMask;
+#if ! SAC_EMSCRIPTEN
+    notifyHandoff(C_FRAME_TAKEN);
+#endif
+    return true;
+}
+
+#if ! SAC_EMSCRIPTEN
+void RenderingSystem::notifyHandoff(int c) {
+    // waiters check 'handoff' while holding L_FRAME: taking it here makes
+    // sure the change isn't notified between their check and their wait
+    { std::lock_guard<std::mutex> lock(mutexes[L_FRAME]); }
+    cond[c].notify_all();
 }
+#endif
 
 #if SAC_INGAME_EDITORS
 void RenderingSystem::forceRenderCommands(RenderCommand* commands, int count) {
-    RenderQueue& outQueue = renderQueue[currentWriteQueue];
+    RenderQueue& outQueue = renderQueue[writeQueue];
     outQueue.count = count;
     if ((int)outQueue.commands.size() < count)
         outQueue.commands.resize(count);
     for (int i=0; i<count; i++)
         outQueue.commands[i] = commands[i];
+    outQueue.step = 0;
 
-#if ! SAC_EMSCRIPTEN
-    // Lock to not change queue while ther thread is reading it
-    mutexes[L_RENDER].lock();
-    // Lock for notifying queue change
-    mutexes[L_QUEUE].lock();
-#endif
-
-    currentWriteQueue = (currentWriteQueue + 1) % 2;
-    newFrameReady = true;
-#if ! SAC_EMSCRIPTEN
-    cond[C_FRAME_READY].notify_all();
-    mutexes[L_QUEUE].unlock();
-    mutexes[L_RENDER].unlock();
-#endif
+    publishFrame();
 }
 #endif
 
@@ -671,6 +919,15 @@ bool RenderingSystem::isVisible(Entity e) const {
 }
 
 bool RenderingSystem::isVisible(const TransformationComponent* tc) const {
+    // camera found by the last DoUpdate, unless cameras changed since
+    if (visibilityCamera && theCameraSystem.membershipVersion() < visibilityCameraVersion) {
+        const CameraComponent* cc = theCameraSystem.tryRead(visibilityCamera);
+        if (cc && cc->fb == DefaultFrameBufferRef) {
+            return IntersectionUtil::rectangleRectangle(
+                theTransformationSystem.tryRead(visibilityCamera), tc);
+        }
+    }
+
     const auto& cameras = theCameraSystem.RetrieveAllEntityWithComponent();
     if (cameras.empty()) {
         return false;
@@ -757,22 +1014,15 @@ void RenderingSystem::disableRendering() {
 }
 
 void RenderingSystem::setFrameQueueWritable(bool b) {
-#if ! SAC_EMSCRIPTEN
-    mutexes[L_QUEUE].lock();
-#endif
     LOGV(1, "Set rendering queue writable= " << b << " and flush queues");
     // Change writable state
     frameQueueWritable = b;
-    // Flush queues
-    renderQueue[0].count = 0;
-    renderQueue[1].count = 0;
+    // Drop the frame waiting to be drawn (the render thread empties its
+    // own queue while rendering is disabled)
+    handoff &= QueueIndexMask;
 #if ! SAC_EMSCRIPTEN
-    cond[C_FRAME_READY].notify_all();
-    mutexes[L_QUEUE].unlock();
-
-    mutexes[L_RENDER].lock();
-    cond[C_RENDER_DONE].notify_all();
-    mutexes[L_RENDER].unlock();
+    notifyHandoff(C_FRAME_TAKEN);
+    notifyHandoff(C_FRAME_READY);
 #endif
 }
 
@@ -20,6 +20,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <condition_variable>
 #include <mutex>
 
@@ -32,6 +33,7 @@
 
 #include "System.h"
 #include "opengl/GLState.h"
+#include "util/LooseGrid.h"
 
 #if SAC_INGAME_EDITORS
 class LevelEditor;
@@ -163,13 +165,17 @@ bool isVisible(const TransformationComponent* tc) const;
 void reloadTextures();
 
 void render();
+// render thread: take the latest frame produced, waiting up to 'timeout'
+// seconds for one if there's none
+bool acquireLatestFrame(float timeout = 0);
+// game thread: unless pipelined, wait for the render thread to take the last
+// frame produced, so that none is dropped
 void waitDrawingComplete();
 
 Buffers::Enum
 changeShaderProgram(EffectRef ref, const Color& color, const glm::mat4& mvp);
 glm::vec2 getTextureSize(const char* textureName);
 glm::vec2 getTextureSize(const TextureRef& textureRef);
-void removeExcessiveFrames(int& readQueue, int& writeQueue);
 
 ColorAlphaTextures chooseTextures(const InternalTexture& tex,
                                   const FramebufferRef& fbo,
@@ -188,6 +194,12 @@ void enableRendering();
 void disableRendering();
 
 AssetAPI* assetAPI;
+// no OpenGL context: assets are only registered, GL is never touched
+bool headless;
+// frames are drawn moved back along the last simulation step, so that the
+// render thread can redraw them smoothly until the next one is produced.
+// Otherwise game and render threads run in lock-step (see waitDrawingComplete)
+bool pipelined;
 
 int windowW, windowH;
 float screenW, screenH;
@@ -197,15 +209,32 @@ FramebufferRef nextValidFBRef;
 std::map<std::string, FramebufferRef> nameToFramebuffer;
 std::map<FramebufferRef, Framebuffer> ref2Framebuffers;
 
-bool newFrameReady, frameQueueWritable;
-int currentWriteQueue;
+std::atomic<bool> frameQueueWritable;
+// triple buffering, latest frame wins: the game thread fills
+// renderQueue[writeQueue], the render thread draws renderQueue[readQueue],
+// and they exchange their queue with the one in 'handoff' (+ NewFrameBit)
 RenderQueue* renderQueue;
+int writeQueue, readQueue;
+std::atomic<int> handoff;
+// frames never drawn, and frames drawn more than once
+std::atomic<unsigned> droppedFrames, reusedFrames;
 
 TextureLibrary textureLibrary;
 EffectLibrary effectLibrary;
 
+// Cameras only visit sprites the culling grid puts near them. Sprites whose
+// transform differs from the previous update are moved in the grid, and it is
+// only rebuilt when its cell size (in world units) is changed.
+float cullingCellSize;
+// last frame, over all cameras: sprites tested against a camera, and sprites
+// skipped thanks to the grid
+struct {
+    unsigned visited, culled;
+} cullingStats;
+
 private:
 void setFrameQueueWritable(bool b);
+void publishFrame();
 EffectRef chooseDefaultShader(bool alphaBlendingOn,
                               bool colorEnabled,
                               bool hasTexture) const;
@@ -213,12 +242,30 @@ EffectRef chooseDefaultShader(bool alphaBlendingOn,
 #if !SAC_EMSCRIPTEN
 std::mutex* mutexes;
 std::condition_variable* cond;
+void notifyHandoff(int c);
 #endif
 
 bool initDone;
 
+LooseGrid cullingGrid;
+uint32_t cullingVersion;
+// entity index -> transform used for its grid cell: same layout as the
+// start of TransformationComponent, so they're compared as raw memory
+struct CullingInput {
+    glm::vec2 position, size;
+    float rotation;
+};
+std::vector<CullingInput> cullingInputs;
+// kept between frames so DoUpdate doesn't allocate
+std::vector<uint32_t> cullingCandidates;
+// camera used by isVisible, found by the last DoUpdate
+Entity visibilityCamera;
+uint32_t visibilityCameraVersion;
+
 private:
-void drawRenderCommands(RenderQueue& commands);
+void drawRenderCommands(const RenderQueue& commands, float rewind);
+// render thread: constant vertices already in the static buffer
+std::vector<bool> uploadedConstants;
 void processDelayedTextureJobs();
 EffectRef defaultShader, defaultShaderNoAlpha, defaultShaderEmpty,
     defaultShaderNoTexture;
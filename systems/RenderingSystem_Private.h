@@ -32,41 +32,50 @@
 #define AlphaBlendedFlagSet 0x6
 #define DebugFlagSet 0x7
 
-#define L_RENDER 0
-#define L_QUEUE 1
-#define L_TEXTURE 2
+#define L_TEXTURE 0
+#define L_FRAME 1
 
-#define C_RENDER_DONE 0
+#define C_FRAME_TAKEN 0
 #define C_FRAME_READY 1
 
+// RenderingSystem::handoff content
+#define QueueIndexMask 0x3
+#define NewFrameBit 0x4
+
 struct RenderingSystem::RenderQueue {
-    RenderQueue() : count(0) {}
+    RenderQueue() : count(0), timestamp(0), step(0) {}
     uint16_t count;
     std::vector<RenderCommand> commands;
+    // when the frame was produced, and the simulation step it covers
+    float timestamp, step;
 };
 
+// Copied to the render queue for each drawn sprite, so only what
+// drawRenderCommands needs lives here. Sort keys are kept aside (see
+// DoUpdate), and GL handles / uv rotation are resolved by the render thread.
 struct RenderingSystem::RenderCommand {
-    uint64_t key;
     union {
         float z;
         int zi;
     };
-    EffectRef effectRef;
     union {
         TextureRef texture;
         FramebufferRef framebuffer;
-        InternalTexture glref;
     };
-    int atlasIndex;
     glm::vec2 uv[2];
     glm::vec2 halfSize;
     Color color;
     glm::vec2 position;
     float rotation;
-    int flags, shapeType;
+    // motion during the last simulation step (pipelined mode)
+    glm::vec2 positionDelta;
+    float rotationDelta;
     uint16_t indiceOffset;
+    EffectRef effectRef;
+    // GL state flags (camera framebuffer for BeginFrameMarker)
+    uint8_t flags;
+    uint8_t shapeType;
     uint8_t rflags;
-    bool rotateUV;
 #if SAC_DEBUG
     Entity e;
     int* batchIndex;
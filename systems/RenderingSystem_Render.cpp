@@ -26,6 +26,7 @@
 #include "CameraSystem.h"
 #include "TransformationSystem.h"
 #include "base/Profiler.h"
+#include "base/TimeUtil.h"
 
 #include <sstream>
 #if SAC_INGAME_EDITORS
@@ -114,7 +115,8 @@ static int drawBatchES2(
     return 0;
 }
 
-static inline void computeUV(RenderingSystem::RenderCommand& rc, const TextureInfo& info) {
+// Returns true if the texture is rotated in its atlas
+static inline bool computeUV(RenderingSystem::RenderCommand& rc, const TextureInfo& info) {
     // Those 2 are used by RenderingSystem to display part of the texture, with different flags.
     // For instance: display a partial-but-opaque-version before the original alpha-blended one.
     // So, their default value are: offset=0,0 and size=1,1
@@ -146,10 +148,11 @@ static inline void computeUV(RenderingSystem::RenderCommand& rc, const TextureIn
         else
             std::swap(rc.uv[0].x, rc.uv[1].x);
     }
-    rc.rotateUV = info.rotateUV;
+    return info.rotateUV;
 }
 
 static inline void addRenderCommandToBatch(const RenderingSystem::RenderCommand& rc,
+    bool rotateUV,
     const Polygon& polygon,
     VertexData* outVertices,
     unsigned short* outIndices,
@@ -194,10 +197,10 @@ static inline void addRenderCommandToBatch(const RenderingSystem::RenderCommand&
     };
 
     if (vertexBufferUpdateNeeded) {
-        outVertices[mapping[rc.rotateUV][0]].uv = glm::vec2(rc.uv[0].x, 1 - rc.uv[0].y);
-        outVertices[mapping[rc.rotateUV][1]].uv = glm::vec2(rc.uv[1].x, 1 - rc.uv[0].y);
-        outVertices[mapping[rc.rotateUV][2]].uv = glm::vec2(rc.uv[0].x, 1 - rc.uv[1].y);
-        outVertices[mapping[rc.rotateUV][3]].uv = glm::vec2(rc.uv[1].x, 1 - rc.uv[1].y);
+        outVertices[mapping[rotateUV][0]].uv = glm::vec2(rc.uv[0].x, 1 - rc.uv[0].y);
+        outVertices[mapping[rotateUV][1]].uv = glm::vec2(rc.uv[1].x, 1 - rc.uv[0].y);
+        outVertices[mapping[rotateUV][2]].uv = glm::vec2(rc.uv[0].x, 1 - rc.uv[1].y);
+        outVertices[mapping[rotateUV][3]].uv = glm::vec2(rc.uv[1].x, 1 - rc.uv[1].y);
     }
 
     if (!(rc.rflags & RenderingFlags::Constant)) {
@@ -245,7 +248,18 @@ Buffers::Enum RenderingSystem::changeShaderProgram(EffectRef ref, const Color& c
     return b;
 }
 
-void RenderingSystem::drawRenderCommands(RenderQueue& commands) {
+static inline void rewindMotion(RenderingSystem::RenderCommand& rc, float rewind) {
+    if (rc.texture == BeginFrameMarker) {
+        // see packCameraAttributes
+        rc.uv[0] -= rewind * rc.positionDelta;
+        rc.z -= rewind * rc.rotationDelta;
+    } else {
+        rc.position -= rewind * rc.positionDelta;
+        rc.rotation -= rewind * rc.rotationDelta;
+    }
+}
+
+void RenderingSystem::drawRenderCommands(const RenderQueue& commands, float rewind) {
     // Worst case scenario: 3 vertices per triangle (no shared vertices)
     unsigned indiceCount = 0;
     // Rendering state
@@ -306,7 +320,13 @@ void RenderingSystem::drawRenderCommands(RenderQueue& commands) {
     // building a new one.
     const unsigned count = commands.count;
     for (unsigned i=0; i< count; i++) {
-        RenderCommand& rc = commands.commands[i];
+        // work on a copy: a frame may be drawn more than once
+        RenderCommand rc = commands.commands[i];
+        // resolved below from rc.texture
+        InternalTexture glref = InternalTexture::Invalid;
+        bool rotateUV = false;
+        if (rewind > 0 && rc.texture != EndFrameMarker)
+            rewindMotion(rc, rewind);
 
         // HANDLE BEGIN/END FRAME MARKERS (new frame OR new camera)
         if (rc.texture == BeginFrameMarker) {
@@ -448,30 +468,26 @@ void RenderingSystem::drawRenderCommands(RenderQueue& commands) {
                     LOGE_IF(!atlasInfo, "TextureInfo for atlas index: "
                         << info->atlasIndex << " not found (ref=" << aRef << ", name='" << atlas[info->atlasIndex].name << "')");
                 }
-                rc.glref = atlasInfo->glref;
-                computeUV(rc, *info);
+                glref = atlasInfo->glref;
+                rotateUV = computeUV(rc, *info);
             } else {
                 rc.uv[0] = glm::vec2(0, 1);
                 rc.uv[1] = glm::vec2(1, 0);
-                rc.rotateUV = 0;
             }
-            if (rc.glref.color == 0)
-                rc.glref.color = whiteTexture;
+            if (glref.color == 0)
+                glref.color = whiteTexture;
         } else {
-            rc.glref = InternalTexture::Invalid;
-
             if (!(currentFlags & EnableBlendingBit)) {
-                rc.glref.color = whiteTexture;
-                rc.glref.alpha = whiteTexture;
+                glref.color = whiteTexture;
+                glref.alpha = whiteTexture;
             }
             rc.uv[0] = glm::vec2(0.0f, 0.0f);
             rc.uv[1] = glm::vec2(1.0f, 1.0f);
-            rc.rotateUV = 0;
         }
 
         // TEXTURE OR COLOR HAS CHANGED ?
         const bool condUseFbo = (useFbo != rcUseFbo);
-        const bool condTexture = (!rcUseFbo && boundTexture != rc.glref && (currentFlags & EnableColorWriteBit));
+        const bool condTexture = (!rcUseFbo && boundTexture != glref && (currentFlags & EnableColorWriteBit));
         const bool condFbo = (rcUseFbo && fboRef != rc.framebuffer);
         const bool condColor = (currentColor != rc.color);
         if (condUseFbo | condTexture | condFbo | condColor) {
@@ -494,7 +510,7 @@ void RenderingSystem::drawRenderCommands(RenderQueue& commands) {
                 boundTexture = InternalTexture::Invalid;
             } else {
                 fboRef = DefaultFrameBufferRef;
-                boundTexture = rc.glref;
+                boundTexture = glref;
 #if SAC_INGAME_EDITORS
                 if (highLight.nonOpaque)
                     boundTexture.alpha = whiteTexture;
@@ -512,15 +528,15 @@ void RenderingSystem::drawRenderCommands(RenderQueue& commands) {
                 }
 
                 /* Map boundTexture (reference) to the glref (real GL texture handles) */
-                auto glref = chooseTextures(boundTexture, fboRef, useFbo);
+                auto glTextures = chooseTextures(boundTexture, fboRef, useFbo);
 
                 /* Change texture */
                 /*   1. Color texture goes to GL_TEXTURE_0 */
                 GL_OPERATION(glActiveTexture(GL_TEXTURE0))
-                GL_OPERATION(glBindTexture(GL_TEXTURE_2D, glref.first))
+                GL_OPERATION(glBindTexture(GL_TEXTURE_2D, glTextures.first))
                 /*   2. Alpha texture goes to GL_TEXTURE_1 */
                 GL_OPERATION(glActiveTexture(GL_TEXTURE1))
-                GL_OPERATION(glBindTexture(GL_TEXTURE_2D, glref.second))
+                GL_OPERATION(glBindTexture(GL_TEXTURE_2D, glTextures.second))
             }
             if (currentColor != rc.color) {
                 currentColor = rc.color;
@@ -549,6 +565,19 @@ void RenderingSystem::drawRenderCommands(RenderQueue& commands) {
         LOGF_IF((activeVertexBuffer == Buffers::Static) && !(rc.rflags & RenderingFlags::Constant), "Ouch2");
 
 
+        // frames may be dropped before being drawn: upload constant vertices
+        // the first time they are seen here rather than when produced
+        if (rc.rflags & RenderingFlags::Constant) {
+            if (uploadedConstants.size() <= rc.indiceOffset)
+                uploadedConstants.resize(rc.indiceOffset + 1, false);
+            if (uploadedConstants[rc.indiceOffset]) {
+                rc.rflags &= ~RenderingFlags::ConstantNeedsUpdate;
+            } else {
+                uploadedConstants[rc.indiceOffset] = true;
+                rc.rflags |= RenderingFlags::ConstantNeedsUpdate;
+            }
+        }
+
         #if SAC_DEBUG
         if (rc.batchIndex) {
             *(rc.batchIndex) = batchSizes.size();
@@ -556,6 +585,7 @@ void RenderingSystem::drawRenderCommands(RenderQueue& commands) {
         #endif
 
         addRenderCommandToBatch(rc,
+            rotateUV,
             polygon,
             vertices + batchVertexCount,
             indices + indiceCount,
@@ -589,8 +619,8 @@ void RenderingSystem::drawRenderCommands(RenderQueue& commands) {
                     continue;
 
                 auto tex = RENDERING(rc.e)->texture;
-                LOGI("      > rc " << j << "[" << std::hex << rc.key << "]: '" << theEntityManager.entityName(rc.e)
-                    << "', z:" << rc.z << ", flags:" << std::hex << rc.flags << std::dec
+                LOGI("      > rc " << j << ": '" << theEntityManager.entityName(rc.e)
+                    << "', z:" << rc.z << ", flags:" << std::hex << (int)rc.flags << std::dec
                     << ", texture: '" << (tex == InvalidTextureRef ? "None" : theRenderingSystem.textureLibrary.ref2Name(tex))
                     << "', color:" << rc.color);
             }
@@ -615,78 +645,59 @@ void RenderingSystem::drawRenderCommands(RenderQueue& commands) {
 }
 
 void RenderingSystem::waitDrawingComplete() {
-#if ! SAC_EMSCRIPTEN || BENCHMARK_MODE
-    PROFILE("Renderer", "wait-drawing-donE", BeginEvent);
-    LOG_USAGE_ONLY(int waitOnQueue = currentWriteQueue);
-    std::unique_lock<std::mutex> lock(mutexes[L_RENDER]);
-    while (newFrameReady && frameQueueWritable) {
-        LOGV(3, "Wait for " << waitOnQueue << " to be emptied by rendering thread");
-        cond[C_RENDER_DONE].wait(lock);
-    }
+#if ! SAC_EMSCRIPTEN
+    if (pipelined)
+        return;
+    PROFILE("Renderer", "wait-drawing-done", BeginEvent);
+    std::unique_lock<std::mutex> lock(mutexes[L_FRAME]);
+    cond[C_FRAME_TAKEN].wait(lock, [this] () {
+        return !(handoff & NewFrameBit) || !frameQueueWritable || pipelined;
+    });
     lock.unlock();
-    PROFILE("Renderer", "wait-drawing-donE", EndEvent);
+    PROFILE("Renderer", "wait-drawing-done", EndEvent);
 #endif
 }
 
 void RenderingSystem::render() {
-#if ! SAC_EMSCRIPTEN
     if (!initDone)
         return;
-    PROFILE("Renderer", "wait-frame", BeginEvent);
-
-    std::unique_lock<std::mutex> lock(mutexes[L_QUEUE]);
-    // processDelayedTextureJobs();
-    while (!newFrameReady && frameQueueWritable) {
-        cond[C_FRAME_READY].wait(lock);
-    }
     #if SAC_DEBUG
     check_GL_errors("PreFrame");
     #endif
-#endif
-    int readQueue = (currentWriteQueue + 1) % 2;
-    newFrameReady = false;
     if (!frameQueueWritable) {
         LOGV(1, "Rendering disabled");
         renderQueue[readQueue].count = 0;
-#if ! SAC_EMSCRIPTEN
-        lock.unlock();
-#endif
         return;
     }
-#if ! SAC_EMSCRIPTEN
-    lock.unlock();
-    PROFILE("Renderer", "wait-frame", EndEvent);
-#endif
+    // pipelined: never waits, the previous frame is drawn again (moved along
+    // its motion) until a new one arrives. Otherwise each frame is drawn
+    // once: wait for the next one, and only draw the current one again if the
+    // game thread stalls, so the window still gets refreshed
+    acquireLatestFrame(pipelined ? 0 : 0.1f);
+    const RenderQueue& inQueue = renderQueue[readQueue];
+
     PROFILE("Renderer", "load-textures", BeginEvent);
     processDelayedTextureJobs();
-#if SAC_ENABLE_LOG && ! SAC_EMSCRIPTEN
-    //float aftertexture= TimeUtil::GetTime();
-#endif
     PROFILE("Renderer", "load-textures", EndEvent);
-#if ! SAC_EMSCRIPTEN
-    if (!mutexes[L_RENDER].try_lock()) {
-        LOGV(3, "HMM Busy render lock");
-        mutexes[L_RENDER].lock();
-    }
-#endif
 
     PROFILE("Renderer", "render", BeginEvent);
-    if (renderQueue[readQueue].count == 0) {
-        LOGW("Arg, nothing to render - probably a bug (queue=" << readQueue << ')');
+    if (inQueue.count == 0) {
+        LOGV(1, "Nothing to render yet");
     } else {
-        RenderQueue& inQueue = renderQueue[readQueue];
-        drawRenderCommands(inQueue);
-        inQueue.count = 0;
+        // the frame is the simulation state at 'timestamp': show the previous
+        // one at that time, and reach it when the next frame is due
+        float rewind = 0;
+        if (pipelined && inQueue.step > 0) {
+            rewind = 1 - glm::clamp(
+                (TimeUtil::GetTime() - inQueue.timestamp) / inQueue.step, 0.0f, 1.0f);
+        }
+        drawRenderCommands(inQueue, rewind);
     }
     LOGV(3, "DONE");
     PROFILE("Renderer", "render", EndEvent);
 #if SAC_INGAME_EDITORS
     RenderingSystem::ImImpl_RenderDrawLists(ImGui::GetDrawData());
 #endif
-#if ! SAC_EMSCRIPTEN
-    cond[C_RENDER_DONE].notify_all();
-    mutexes[L_RENDER].unlock();
-#endif
 }
 
 static void computeVerticesScreenPos(const std::vector<glm::vec2>& points, const glm::vec2& position, const glm::vec2& hSize, float rotation, float z, VertexData* out) {
@@ -170,11 +170,11 @@ void RenderingSystem::processDelayedTextureJobs() {
 TextureRef RenderingSystem::loadTextureFile(const char* assetName) {
     PROFILE("Texture", "loadTextureFile", BeginEvent);
 #ifndef SAC_EMSCRIPTEN
-    mutexes[L_QUEUE].lock();
+    mutexes[L_TEXTURE].lock();
 #endif
     TextureRef result = textureLibrary.load(assetName);
 #ifndef SAC_EMSCRIPTEN
-    mutexes[L_QUEUE].unlock();
+    mutexes[L_TEXTURE].unlock();
 #endif
     PROFILE("Texture", "loadTextureFile", EndEvent);
     return result;
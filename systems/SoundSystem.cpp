@@ -28,6 +28,8 @@
 INSTANCE_IMPL(SoundSystem);
 
 SoundSystem::SoundSystem() : ComponentSystemImpl<SoundComponent>(HASH("Sound", 0x2e56fb12)), nextValidRef(1), mute(false) {
+    // sound API may not be usable from other threads
+    declareAccesses({}, {}, true);
     /* nothing saved */
     SoundComponent sc;
 
@@ -30,14 +30,15 @@
 
 
 typedef glm::ivec2 CellCoords;
-typedef std::vector<Entity> Cell; //...
+// entities in each cell, only needed during update
+typedef FrameVector<Entity> Cell;
 
-std::vector<Cell> cells;
 std::vector<glm::ivec2> coords;
 
 INSTANCE_IMPL(SpatialPartitionSystem);
 
 SpatialPartitionSystem::SpatialPartitionSystem() : ComponentSystemImpl<SpatialPartitionComponent>(HASH("SpatialPartition", 0x35df9814)) {
+    declareAccesses({ HASH("Transformation", 0x4d33e992), HASH("BackInTime", 0x7c9eb7e5) }, {});
     SpatialPartitionComponent tc;
     componentSerializer.add(new Property<int>(HASH("count", 0x78b8273a), OFFSET(count, tc)));
     cellSize = 3;
@@ -48,7 +49,7 @@ SpatialPartitionSystem::SpatialPartitionSystem() : ComponentSystemImpl<SpatialPa
 }
 
 #if SAC_DEBUG
-void drawDebug(float cellSize, const glm::vec2& minPos, int total, glm::ivec2 gridSize) {
+void drawDebug(const FrameVector<Cell>& cells, float cellSize, const glm::vec2& minPos, int total, glm::ivec2 gridSize) {
     // float avg = total / (float)cells.size();
     for (size_t i=0; i<cells.size(); i++) {
         if (cells[i].empty()) {
@@ -78,14 +79,20 @@ void SpatialPartitionSystem::DoUpdate(float) {
     const float invCellSize = 1.0f / cellSize;
     glm::vec2 minPos(FLT_MAX, FLT_MAX), maxPos(-FLT_MAX, -FLT_MAX);
 
-    FOR_EACH_ENTITY(SpatialPartition, e)
-        const auto* tc = TRANSFORM(e);
-        const auto* hc = BACK_IN_TIME(e);
+    // BackInTime components are stored as columns (entities without one are
+    // skipped)
+    View<SpatialPartitionComponent, const TransformationComponent> view(*this, theTransformationSystem);
+
+    for (const auto& row: view) {
+        const auto* tc = row.get<1>();
+        BackInTimeComponent hc;
+        if (!theBackInTimeSystem.read(row.entity, hc))
+            continue;
         float maxSizeComp =
-            glm::max(tc->size.x, glm::max(tc->size.y, glm::max(hc->size.x, hc->size.y)));
-        minPos = glm::min(minPos, glm::min(tc->position, hc->position) - maxSizeComp);
-        maxPos = glm::max(maxPos, glm::max(tc->position, hc->position) + maxSizeComp);
-    END_FOR_EACH()
+            glm::max(tc->size.x, glm::max(tc->size.y, glm::max(hc.size.x, hc.size.y)));
+        minPos = glm::min(minPos, glm::min(tc->position, hc.position) - maxSizeComp);
+        maxPos = glm::max(maxPos, glm::max(tc->position, hc.position) + maxSizeComp);
+    }
 
     // make sure cell storage is correctly sized
     // and reset storage
@@ -95,18 +102,19 @@ void SpatialPartitionSystem::DoUpdate(float) {
     gridSize.x = (ma.x - mi.x + 1);
     gridSize.y = (ma.y - mi.y + 1);
     int cellCount = gridSize.x *gridSize.y;
-    cells.resize(cellCount);
-    for (int i=0; i<cellCount; i++) {
-        cells[i].clear();
-    }
+    FrameVector<Cell> cells(cellCount);
     coords.clear();
     int count = 0;
 
-    FOR_EACH_ENTITY_COMPONENT(SpatialPartition, e, comp)
-        const auto* tc = TRANSFORM(e);
+    for (const auto& row: view) {
+        const Entity e = row.entity;
+        auto* comp = row.get<0>();
+        const auto* tc = row.get<1>();
+        BackInTimeComponent hc;
+        if (!theBackInTimeSystem.read(e, hc))
+            continue;
         AABB aabb;
         {
-            const auto* hc = BACK_IN_TIME(e);
             AABB frames[2];
             IntersectionUtil::computeAABB(
                 tc->position - minPos,
@@ -114,9 +122,9 @@ void SpatialPartitionSystem::DoUpdate(float) {
                 tc->rotation,
                 frames[0]);
             IntersectionUtil::computeAABB(
-                hc->position - minPos,
-                hc->size,
-                hc->rotation,
+                hc.position - minPos,
+                hc.size,
+                hc.rotation,
                 frames[1]);
             aabb = IntersectionUtil::mergeAABB(frames, 2);
         }
@@ -138,11 +146,11 @@ void SpatialPartitionSystem::DoUpdate(float) {
                 comp->count++;
             }
         }
-    END_FOR_EACH()
+    }
 
     #if SAC_DEBUG
     if (showDebug) {
-        drawDebug(cellSize, minPos, entityWithComponent.size(), gridSize);
+        drawDebug(cells, cellSize, minPos, entityWithComponent.size(), gridSize);
     }
     #endif
 }
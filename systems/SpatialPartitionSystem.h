@@ -48,6 +48,8 @@ UPDATABLE_SYSTEM(SpatialPartition)
         glm::ivec2 gridSize;
 #if SAC_DEBUG
         bool showDebug;
+        // debug drawing creates entities
+        bool needsExclusiveUpdate() const override { return showDebug; }
 #endif
 
 };
@@ -37,32 +37,69 @@
 #include "base/EntityManager.h"
     
 std::map<hash_t, ComponentSystem*> ComponentSystem::registry;
+ComponentSystem* ComponentSystem::signatureBitOwners[ComponentSystem::MaxSystemCount];
+const unsigned ComponentSystem::MaxSystemCount;
+const uint32_t ComponentSystem::InvalidDenseIndex;
+const uint32_t ComponentSystem::SparsePageShift;
+const uint32_t ComponentSystem::SparsePageSize;
+uint32_t ComponentSystem::currentVersion = 1;
 
 
-bool ComponentSystem::entityHasComponent(const std::vector<Entity>& c, Entity e) {
-    return std::binary_search(c.begin(), c.end(), e);
-}
-
-ComponentSystem::ComponentSystem(hash_t n) : type(ComponentType::POD), id(n)
+ComponentSystem::ComponentSystem(hash_t n) : type(ComponentType::POD), storage(ComponentStorage::Direct), id(n)
+    , accessesDeclared(false), gameThreadOnly(false), timeSliced(false)
+    , columnsSize(0), sliceBegin(0), sliceEnd(0), sliceCursor(0), lastMembershipChange(0)
 #if SAC_DEBUG
     , updateDuration(0)
 #endif
 {
-    bool inserted = registry.insert(std::make_pair(id, this)).second;
-    LOGF_IF(!inserted, "System with name '" << INV_HASH(id) << "' already exists");
+    registerSystem();
 }
 
-ComponentSystem::ComponentSystem(hash_t n, ComponentType::Enum t) : type(t), id(n)
+ComponentSystem::ComponentSystem(hash_t n, ComponentType::Enum t, ComponentStorage::Enum s) : type(t), storage(s), id(n)
+    , accessesDeclared(false), gameThreadOnly(false), timeSliced(false)
+    , columnsSize(0), sliceBegin(0), sliceEnd(0), sliceCursor(0), lastMembershipChange(0)
 #if SAC_DEBUG
     , updateDuration(0)
 #endif
 {
+    registerSystem();
+}
+
+void ComponentSystem::registerSystem() {
     bool inserted = registry.insert(std::make_pair(id, this)).second;
     LOGF_IF(!inserted, "System with name '" << INV_HASH(id) << "' already exists");
+
+    // pick the first free signature bit
+    for (signatureBit = 0; signatureBit < MaxSystemCount; signatureBit++) {
+        if (!signatureBitOwners[signatureBit]) {
+            signatureBitOwners[signatureBit] = this;
+            return;
+        }
+    }
+    LOGF("Too many systems registered (max: " << MaxSystemCount << ')');
+}
+
+void ComponentSystem::declareAccesses(std::initializer_list<hash_t> r, std::initializer_list<hash_t> w, bool gameThread) {
+    accessesDeclared = true;
+    gameThreadOnly = gameThread;
+    reads.assign(r.begin(), r.end());
+    writes.assign(w.begin(), w.end());
+    if (std::find(writes.begin(), writes.end(), id) == writes.end()) {
+        writes.push_back(id);
+    }
 }
 
 ComponentSystem::~ComponentSystem() {
     registry.erase(id);
+    if (signatureBit < MaxSystemCount && signatureBitOwners[signatureBit] == this) {
+        signatureBitOwners[signatureBit] = 0;
+    }
+    for (auto* page: sparsePages) {
+        delete[] page;
+    }
+    for (auto& column: columns) {
+        free(column.data);
+    }
 }
 
 void* ComponentSystem::enlargeComponentsArray(
@@ -84,19 +121,205 @@ void* ComponentSystem::enlargeComponentsArray(
     return ptr;
 }
 
+void* ComponentSystem::shrinkComponentsArray(
+    void* array, size_t compSize, uint32_t* size, uint32_t requested) {
+    LOGV(1, "Shrinking storage of " << INV_HASH(id) << "System. Previously acquired components may be invalid");
+    void* ptr = realloc(array, requested * compSize);
+    // shrinking in place can't fail, but realloc is allowed to
+    if (!ptr)
+        return array;
+    (*size) = requested;
+    return ptr;
+}
+
+void ComponentSystem::addColumn(size_t offset, size_t size) {
+    LOGF_IF(storage != ComponentStorage::Soa, INV_HASH(id) << "System doesn't use Soa storage");
+    LOGF_IF(!entityWithComponent.empty(), "Columns of " << INV_HASH(id) << "System must be added before components");
+    Column column;
+    column.offset = offset;
+    column.size = size;
+    column.data = static_cast<uint8_t*>(malloc(columnsSize * size));
+    columns.push_back(column);
+}
+
+uint8_t* ComponentSystem::columnData(size_t offset) const {
+    for (const auto& column: columns) {
+        if (column.offset == offset)
+            return column.data;
+    }
+    LOGF("No column at offset " << offset << " in " << INV_HASH(id) << "System");
+    return 0;
+}
+
+void ComponentSystem::reserveColumns(uint32_t requested) {
+    if (requested <= columnsSize)
+        return;
+    uint32_t size = columnsSize;
+    for (auto& column: columns) {
+        size = columnsSize;
+        column.data = static_cast<uint8_t*>(enlargeComponentsArray(
+            column.data, column.size, &size, requested, true));
+    }
+    columnsSize = size;
+}
+
+size_t ComponentSystem::shrinkColumns(uint32_t requested) {
+    if (requested >= columnsSize)
+        return 0;
+    size_t freed = 0;
+    // capacity is the smallest column (shrinking one may fail)
+    uint32_t capacity = columnsSize;
+    for (auto& column: columns) {
+        uint32_t size = columnsSize;
+        column.data = static_cast<uint8_t*>(shrinkComponentsArray(
+            column.data, column.size, &size, requested));
+        freed += (columnsSize - size) * column.size;
+        capacity = glm::min(capacity, size);
+    }
+    columnsSize = capacity;
+    return freed;
+}
+
+void ComponentSystem::scatterColumns(uint32_t index, const void* component) {
+    const uint8_t* in = static_cast<const uint8_t*>(component);
+    for (auto& column: columns) {
+        memcpy(column.data + index * column.size, in + column.offset, column.size);
+    }
+}
+
+void ComponentSystem::gatherColumns(uint32_t index, void* component) const {
+    uint8_t* out = static_cast<uint8_t*>(component);
+    for (const auto& column: columns) {
+        memcpy(out + column.offset, column.data + index * column.size, column.size);
+    }
+}
+
+void ComponentSystem::moveColumns(uint32_t to, uint32_t from) {
+    for (auto& column: columns) {
+        memcpy(column.data + to * column.size, column.data + from * column.size, column.size);
+    }
+}
+
+void ComponentSystem::storeComponent(Entity e, const void* component) {
+    if (storage != ComponentStorage::Soa)
+        return;
+    const uint32_t index = denseIndex(e);
+    LOGF_IF(index == InvalidDenseIndex || entityWithComponent[index] != e, "Entity '" << theEntityManager.entityName(e) << "' has no component of type '" << INV_HASH(id) << "'");
+    scatterColumns(index, component);
+}
+
+void ComponentSystem::setDenseIndex(Entity e, uint32_t index) {
+    const uint32_t slot = EntityHandle::index(e);
+    const uint32_t page = slot >> SparsePageShift;
+    if (page >= sparsePages.size()) {
+        sparsePages.resize(page + 1, 0);
+    }
+    if (!sparsePages[page]) {
+        sparsePages[page] = new uint32_t[SparsePageSize];
+        std::fill(sparsePages[page], sparsePages[page] + SparsePageSize, InvalidDenseIndex);
+    }
+    sparsePages[page][slot & (SparsePageSize - 1)] = index;
+}
+
 void ComponentSystem::addEntity(Entity entity) {
-    // sorted insert
-    auto it=entityWithComponent.begin();
-    for (; it!=entityWithComponent.end(); ++it) {
-        if (*it > entity)
-            break;
+    lastMembershipChange = currentVersion;
+    if (storage != ComponentStorage::Direct) {
+        setDenseIndex(entity, entityWithComponent.size());
+        entityWithComponent.push_back(entity);
+        return;
+    }
+
+    setDirectOwner(entity, entity);
+
+    // sorted insert; entities are mostly added in increasing order
+    if (entityWithComponent.empty() || indexLess(entityWithComponent.back(), entity)) {
+        entityWithComponent.push_back(entity);
+    } else {
+        entityWithComponent.insert(
+            std::upper_bound(entityWithComponent.begin(), entityWithComponent.end(), entity, indexLess),
+            entity);
     }
-    entityWithComponent.insert(it, entity);
+}
+
+void ComponentSystem::setDirectOwner(Entity e, Entity owner) {
+    const uint32_t index = EntityHandle::index(e);
+    if (index >= directOwners.size()) {
+        directOwners.resize(2 * (index + 1), 0);
+    }
+    directOwners[index] = owner;
+}
+
+void ComponentSystem::addEntities(const Entity* entities, unsigned count) {
+    if (storage != ComponentStorage::Direct) {
+        for (unsigned i=0; i<count; i++) {
+            addEntity(entities[i]);
+        }
+        return;
+    }
+
+    lastMembershipChange = currentVersion;
+    for (unsigned i=0; i<count; i++) {
+        setDirectOwner(entities[i], entities[i]);
+    }
+
+    const auto previousSize = entityWithComponent.size();
+    entityWithComponent.insert(entityWithComponent.end(), entities, entities + count);
+    auto middle = entityWithComponent.begin() + previousSize;
+    std::sort(middle, entityWithComponent.end(), indexLess);
+    if (previousSize && indexLess(*middle, *(middle - 1))) {
+        std::inplace_merge(entityWithComponent.begin(), middle, entityWithComponent.end(), indexLess);
+    }
+}
+
+void ComponentSystem::DeleteMany(const Entity* entities, unsigned count) {
+    // sparse storage: swap-with-last is already O(1) per entity
+    if (storage != ComponentStorage::Direct || count == 1) {
+        for (unsigned i=0; i<count; i++) {
+            Delete(entities[i]);
+        }
+        return;
+    }
+
+    lastMembershipChange = currentVersion;
+    FrameVector<Entity> sorted(entities, entities + count);
+    std::sort(sorted.begin(), sorted.end(), indexLess);
+
+    // single pass compaction of the (sorted) entity list
+    auto removed = sorted.begin();
+    auto out = entityWithComponent.begin();
+    for (auto it = entityWithComponent.begin(); it != entityWithComponent.end(); ++it) {
+        while (removed != sorted.end() && indexLess(*removed, *it)) {
+            LOGF("Unable to find entity '" << theEntityManager.entityName(*removed) << "' in components '" << INV_HASH(getId()) << "'");
+            ++removed;
+        }
+        if (removed != sorted.end() && *removed == *it) {
+            setDirectOwner(*it, 0);
+            ++removed;
+        } else {
+            *out++ = *it;
+        }
+    }
+    LOGF_IF(removed != sorted.end(), "Unable to find entity '" << theEntityManager.entityName(*removed) << "' in components '" << INV_HASH(getId()) << "'");
+    entityWithComponent.erase(out, entityWithComponent.end());
 }
 
 void ComponentSystem::Delete(Entity entity) {
-    auto it = std::find(entityWithComponent.begin(), entityWithComponent.end(), entity);
-    LOGF_IF(it == entityWithComponent.end(), "Unable to find entity '" << theEntityManager.entityName(entity) << "' in components '" << INV_HASH(getId()) << "'");
+    lastMembershipChange = currentVersion;
+    if (storage != ComponentStorage::Direct) {
+        const uint32_t index = denseIndex(entity);
+        LOGF_IF(index == InvalidDenseIndex || entityWithComponent[index] != entity, "Unable to find entity '" << theEntityManager.entityName(entity) << "' in components '" << INV_HASH(getId()) << "'");
+        // swap with last
+        const Entity last = entityWithComponent.back();
+        entityWithComponent[index] = last;
+        setDenseIndex(last, index);
+        setDenseIndex(entity, InvalidDenseIndex);
+        entityWithComponent.pop_back();
+        return;
+    }
+
+    auto it = std::lower_bound(entityWithComponent.begin(), entityWithComponent.end(), entity, indexLess);
+    LOGF_IF(it == entityWithComponent.end() || *it != entity, "Unable to find entity '" << theEntityManager.entityName(entity) << "' in components '" << INV_HASH(getId()) << "'");
+    setDirectOwner(entity, 0);
     entityWithComponent.erase(it);
 }
 
@@ -108,16 +331,40 @@ void ComponentSystem::deleteAllEntities() {
     LOGF_IF(!entityWithComponent.empty(), "Entity list should be empty after deleteAll");
 }
 
+size_t ComponentSystem::compact() {
+    size_t freed = (entityWithComponent.capacity() - entityWithComponent.size()) * sizeof(Entity);
+    entityWithComponent.shrink_to_fit();
+
+    uint32_t used = entityWithComponent.size();
+    if (storage == ComponentStorage::Direct) {
+        used = entityWithComponent.empty() ? 0 : EntityHandle::index(entityWithComponent.back()) + 1;
+        if (used < directOwners.size()) {
+            freed += (directOwners.size() - used) * sizeof(Entity);
+            directOwners.resize(used);
+            directOwners.shrink_to_fit();
+        }
+    } else {
+        // release pages without any entity
+        for (auto& page: sparsePages) {
+            if (page && std::find_if(page, page + SparsePageSize, [] (uint32_t i) {
+                    return i != InvalidDenseIndex; }) == page + SparsePageSize) {
+                delete[] page;
+                page = 0;
+                freed += SparsePageSize * sizeof(uint32_t);
+            }
+        }
+        while (!sparsePages.empty() && !sparsePages.back()) sparsePages.pop_back();
+        sparsePages.shrink_to_fit();
+    }
+    return freed;
+}
+
 unsigned ComponentSystem::entityCount() const {
     return entityWithComponent.size();
 }
 
 
 
-const std::vector<Entity>& ComponentSystem::RetrieveAllEntityWithComponent() const {
-    return entityWithComponent;
-}
-
 void ComponentSystem::forEachEntityDo(std::function<void(Entity)> func) {
     for (Entity e: entityWithComponent) {
         func(e);
@@ -136,12 +383,23 @@ int ComponentSystem::deserialize(Entity entity, uint8_t* in, int size) {
         component = componentAsVoidPtr(entity);
     }
     int s = componentSerializer.deserializeObject(in, size, component);
+    storeComponent(entity, component);
     return s;
 }
 
 void ComponentSystem::applyEntityTemplate(Entity entity, const PropertyNameValueMap& propMap, LocalizeAPI* localizeAPI) {
     void* component = componentAsVoidPtr(entity);
     ComponentFactory::applyTemplate(entity, component, propMap, componentSerializer.getProperties(), localizeAPI);
+    storeComponent(entity, component);
+}
+
+void ComponentSystem::setUpdatePolicy(const UpdatePolicy& policy) {
+    LOGW_IF(policy.budget && !timeSliced, INV_HASH(id) << "System can't be time-sliced");
+    updatePolicy = policy;
+    updatePolicy.period = glm::max(1u, policy.period);
+    updatePolicy.phase = policy.phase % updatePolicy.period;
+    if (!timeSliced)
+        updatePolicy.budget = 0;
 }
 
 void ComponentSystem::Update(float dt) {
@@ -149,6 +407,22 @@ void ComponentSystem::Update(float dt) {
 #if SAC_DEBUG
     float before = TimeUtil::GetTime();
 #endif
+    const uint32_t count = entityWithComponent.size();
+    const uint32_t budget = updatePolicy.budget;
+    if (budget && count > budget) {
+        if (sliceCursor >= count)
+            sliceCursor = 0;
+        sliceBegin = sliceCursor;
+        sliceEnd = glm::min(count, sliceBegin + budget);
+        sliceCursor = sliceEnd;
+        // each entity is processed once every 'rounds' updates
+        const uint32_t rounds = (count + budget - 1) / budget;
+        dt *= rounds;
+    } else {
+        sliceBegin = sliceCursor = 0;
+        // entities added during DoUpdate are processed too
+        sliceEnd = 0xffffffff;
+    }
     DoUpdate(dt);
 #if SAC_DEBUG
     updateDuration = TimeUtil::GetTime() - before;
@@ -432,6 +706,7 @@ bool ComponentSystem::addEntityPropertiesToBar(Entity e, void* /*bar*/) {
                 break;
         }
     }
+    storeComponent(e, comp);
     return true;
 }
 
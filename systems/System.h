@@ -24,12 +24,17 @@
 #include <map>
 
 #include "base/Entity.h"
+#include "base/FrameArena.h"
 #include "util/Serializer.h"
 #include "util/MurmurHash.h"
 #include <functional>
 #include "base/Log.h"
 
 #include <cstdlib>
+#include <algorithm>
+#include <initializer_list>
+#include <tuple>
+#include <type_traits>
 
 // #include "base/EntityManager.h"
 
@@ -39,22 +44,61 @@ namespace ComponentType {
     enum Enum { POD, Complex };
 }
 
+// How components are laid out in memory:
+//   - Direct: components are indexed by entity id. Lookups are a plain array
+//     access, but storage is sized by the highest entity id ever added.
+//   - Sparse: components are packed in a dense array (same order as
+//     entityWithComponent) and a paged entity -> index table is used for
+//     lookups. Memory scales with the number of components.
+//   - Soa: like Sparse, but each field of the (POD) component is stored in its
+//     own array. Loops touching a few fields only load these; in exchange
+//     components can't be accessed through a T*, only copied (read/write) or
+//     through their columns (see ComponentSystemImpl::column).
+namespace ComponentStorage {
+    enum Enum { Direct, Sparse, Soa };
+}
+
 class ComponentSystem {
     public:
     ComponentSystem(hash_t id);
-    ComponentSystem(hash_t id, ComponentType::Enum type);
+    ComponentSystem(hash_t id,
+                    ComponentType::Enum type,
+                    ComponentStorage::Enum storage = ComponentStorage::Direct);
 
     virtual ~ComponentSystem();
 
     hash_t getId() const { return id; }
+    ComponentStorage::Enum getStorage() const { return storage; }
+    // bit assigned to this system at registration, used by EntityManager
+    ComponentSignature getSignature() const { return ((ComponentSignature)1) << signatureBit; }
 
     virtual void Add(Entity entity) = 0;
     virtual void Delete(Entity entity);
+    // Bulk versions: storage grows at most once, and entities are removed
+    // from entityWithComponent in a single pass (scratch memory comes from
+    // the frame arena, so per-frame batches don't touch the heap)
+    virtual void AddMany(const Entity* entities, unsigned count) = 0;
+    virtual void DeleteMany(const Entity* entities, unsigned count);
     void deleteAllEntities();
+    // Frees storage not needed by current components (e.g: after a mass
+    // deletion) and returns the number of bytes reclaimed. Like growing, it
+    // may move POD components.
+    virtual size_t compact();
     virtual uint8_t* saveComponent(Entity entity, uint8_t* out = 0) = 0;
     virtual void* componentAsVoidPtr(Entity e) = 0;
-
-    bool hasComponent(Entity e) const { return entityHasComponent(entityWithComponent, e); }
+    // Soa storage hands out a copy in componentAsVoidPtr: edits are applied
+    // by storing it back (no-op for other storages)
+    void storeComponent(Entity e, const void* component);
+
+    // O(1), and false for stale handles (see EntityHandle)
+    bool hasComponent(Entity e) const {
+        if (storage != ComponentStorage::Direct) {
+            const uint32_t index = denseIndex(e);
+            return index != InvalidDenseIndex && entityWithComponent[index] == e;
+        }
+        const uint32_t index = EntityHandle::index(e);
+        return index < directOwners.size() && directOwners[index] == e;
+    }
     void applyEntityTemplate(Entity entity,
                              const std::map<hash_t, uint8_t*>& propMap,
                              LocalizeAPI* localizeAPI);
@@ -62,11 +106,56 @@ class ComponentSystem {
     int deserialize(Entity entity, uint8_t* out, int size);
     unsigned entityCount() const;
     void forEachEntityDo(std::function<void(Entity)> func);
-    const std::vector<Entity>& RetrieveAllEntityWithComponent() const;
+    const std::vector<Entity>& RetrieveAllEntityWithComponent() const { return entityWithComponent; }
 
     void Update(float dt);
 
+    // Data accessed by DoUpdate, used by SystemScheduler to update independent
+    // systems concurrently. Other systems are designated by id, and a system
+    // always writes its own components.
+    // Systems not declaring their accesses (the default) may touch anything,
+    // including creating/deleting entities: they're updated alone, on the
+    // game thread.
+    bool hasDeclaredAccesses() const { return accessesDeclared; }
+    const std::vector<hash_t>& getReads() const { return reads; }
+    const std::vector<hash_t>& getWrites() const { return writes; }
+    bool updatesOnGameThreadOnly() const { return gameThreadOnly; }
+    // Checked every frame: a system declaring its accesses may still need to
+    // be updated alone from time to time (e.g: debug drawing creates entities)
+    virtual bool needsExclusiveUpdate() const { return !accessesDeclared; }
+
+    // How often SystemScheduler updates the system, by default on every game
+    // update. Systems iterating with FOR_EACH_ENTITY_COMPONENT_SLICED can also
+    // be time-sliced: they then process 'budget' entities per update,
+    // round-robin, and are given the time elapsed since these entities were
+    // last processed.
+    struct UpdatePolicy {
+        UpdatePolicy() : period(1), phase(0), budget(0) {}
+        // updated on game updates where (update % period) == phase
+        unsigned period, phase;
+        // 0 means all entities
+        unsigned budget;
+    };
+    void setUpdatePolicy(const UpdatePolicy& policy);
+    const UpdatePolicy& getUpdatePolicy() const { return updatePolicy; }
+    bool supportsTimeSlicing() const { return timeSliced; }
+
+    // Versions count game updates (see NextVersion): consumers remember the
+    // version at which they last ran to know if components were added to or
+    // removed from a system since. Component contents aren't tracked, as
+    // they're also written through pointers kept across frames.
+    // last version at which a component was added or removed
+    uint32_t membershipVersion() const { return lastMembershipChange; }
+
+    static uint32_t CurrentVersion() { return currentVersion; }
+    // called once per game update, before systems are updated
+    static void NextVersion() { currentVersion++; }
+
     static ComponentSystem* GetById(hash_t t);
+    static ComponentSystem* GetBySignatureBit(unsigned bit) { return signatureBitOwners[bit]; }
+
+    // last 2 bits of ComponentSignature are reserved by EntityManager
+    static const unsigned MaxSystemCount = 62;
 
     static std::vector<hash_t> registeredSystemIds();
     static const std::map<hash_t, ComponentSystem*>& registeredSystems();
@@ -78,22 +167,92 @@ class ComponentSystem {
 
     protected:
     virtual void DoUpdate(float dt) = 0;
+    void declareAccesses(std::initializer_list<hash_t> reads,
+                         std::initializer_list<hash_t> writes,
+                         bool gameThreadOnly = false);
+    // DoUpdate only processes its slice (see UpdatePolicy)
+    void enableTimeSlicing() { timeSliced = true; }
     static std::map<hash_t, ComponentSystem*> registry;
+    static ComponentSystem* signatureBitOwners[MaxSystemCount];
+    void registerSystem();
 
     void* enlargeComponentsArray(void* array,
                                  size_t compSize,
                                  uint32_t* size,
                                  uint32_t requested,
                                  bool f);
+    void* shrinkComponentsArray(void* array,
+                                size_t compSize,
+                                uint32_t* size,
+                                uint32_t requested);
     void addEntity(Entity e);
+    void addEntities(const Entity* entities, unsigned count);
+
+    // Soa storage: field at 'offset' of the components is stored in 'data'
+    struct Column {
+        size_t offset, size;
+        uint8_t* data;
+    };
+    void addColumn(size_t offset, size_t size);
+    uint8_t* columnData(size_t offset) const;
+    void reserveColumns(uint32_t requested);
+    size_t shrinkColumns(uint32_t requested);
+    // copy component fields from/to the index-th entry of each column
+    void scatterColumns(uint32_t index, const void* component);
+    void gatherColumns(uint32_t index, void* component) const;
+    void moveColumns(uint32_t to, uint32_t from);
 
     protected:
     ComponentType::Enum type;
+    ComponentStorage::Enum storage;
     hash_t id;
+    uint8_t signatureBit;
+    // Direct storage: list of entities, sorted by index.
+    // Sparse/Soa storage: dense list of entities, entityWithComponent[i] owns
+    // the i-th component.
     std::vector<Entity> entityWithComponent;
+    // Direct storage: entity index -> handle owning the component (or 0)
+    std::vector<Entity> directOwners;
+
+    // Sparse/Soa storage: entity -> dense index table, allocated by pages
+    static const uint32_t InvalidDenseIndex = 0xffffffff;
+    static const uint32_t SparsePageShift = 10;
+    static const uint32_t SparsePageSize = 1 << SparsePageShift;
+    std::vector<uint32_t*> sparsePages;
+
+    std::vector<Column> columns;
+    uint32_t columnsSize;
+
+    bool accessesDeclared, gameThreadOnly;
+    std::vector<hash_t> reads, writes;
+
+    UpdatePolicy updatePolicy;
+    bool timeSliced;
+    // entities of the current update's slice, and start of the next one
+    uint32_t sliceBegin, sliceEnd, sliceCursor;
+
+    uint32_t lastMembershipChange;
+    static uint32_t currentVersion;
+
+    uint32_t denseIndex(Entity e) const {
+        const uint32_t index = EntityHandle::index(e);
+        const uint32_t page = index >> SparsePageShift;
+        if (page >= sparsePages.size() || !sparsePages[page])
+            return InvalidDenseIndex;
+        return sparsePages[page][index & (SparsePageSize - 1)];
+    }
+    void setDenseIndex(Entity e, uint32_t index);
+    void setDirectOwner(Entity e, Entity owner);
+
+    // index of entity's component in the components array
+    uint32_t componentIndex(uint32_t denseIdx, Entity e) const {
+        return (storage != ComponentStorage::Direct) ? denseIdx : EntityHandle::index(e);
+    }
 
     Serializer componentSerializer;
-    static bool entityHasComponent(const std::vector<Entity>& c, Entity e);
+    static bool indexLess(Entity a, Entity b) {
+        return EntityHandle::index(a) < EntityHandle::index(b);
+    }
 
     public:
     const Serializer& getSerializer() const { return componentSerializer; }
@@ -108,40 +267,118 @@ template <typename T> class ComponentSystemImpl : public ComponentSystem {
     public:
     ComponentSystemImpl(hash_t t,
                         ComponentType::Enum type = ComponentType::POD,
-                        unsigned defaultStorageSize = 8)
-        : ComponentSystem(t, type) {
+                        unsigned defaultStorageSize = 8,
+                        ComponentStorage::Enum storage = ComponentStorage::Direct)
+        : ComponentSystem(t, type, storage) {
         LOGF_IF(defaultStorageSize == 0, "Storage size must be > 0");
+        LOGF_IF(storage == ComponentStorage::Soa && type != ComponentType::POD,
+                "Soa storage is only available for POD components");
         componentsSize = 0;
-        components = reinterpret_cast<T*>(enlargeComponentsArray(
-            0, sizeof(T), &componentsSize, defaultStorageSize, false));
+        components = 0;
+        soaCopy = 0;
+        if (storage == ComponentStorage::Soa) {
+            columnsSize = defaultStorageSize;
+            soaCopy = new T();
+        } else if (type == ComponentType::POD) {
+            components = reinterpret_cast<T*>(enlargeComponentsArray(
+                0, sizeof(T), &componentsSize, defaultStorageSize, false));
+        }
     }
 
-    ~ComponentSystemImpl() { free(components); }
+    ~ComponentSystemImpl() {
+        if (type == ComponentType::Complex) {
+            for (uint32_t i = 0; i < entityWithComponent.size(); i++) {
+                componentPtr(componentIndex(i, entityWithComponent[i]))->~T();
+            }
+            for (auto* page: pages) free(page);
+        }
+        free(components);
+        delete soaCopy;
+    }
 
     void Add(Entity entity) {
-        LOGF_IF(entityHasComponent(entityWithComponent, entity),
+        LOGF_IF(hasComponent(entity),
                 "Entity '" /*<< theEntityManager.entityName(entity)*/
                            << "' has the same component('" << INV_HASH(getId())
                            << "') twice!");
 
-        if (entity >= componentsSize) {
-            if (type == ComponentType::POD) {
-                components = reinterpret_cast<T*>(enlargeComponentsArray(
-                    components, sizeof(T), &componentsSize, entity + 1, true));
+        const uint32_t index = (storage != ComponentStorage::Direct)
+                                   ? entityWithComponent.size()
+                                   : EntityHandle::index(entity);
+        reserveComponents(index, index + 1);
+        if (storage == ComponentStorage::Soa) {
+            const T t = T();
+            scatterColumns(index, &t);
+        } else {
+            new (componentPtr(index)) T();
+        }
+        addEntity(entity);
+    }
+
+    void AddMany(const Entity* entities, unsigned count) {
+        if (count == 0) return;
+
+        if (storage != ComponentStorage::Direct) {
+            const uint32_t first = entityWithComponent.size();
+            reserveComponents(first, first + count);
+            if (storage == ComponentStorage::Soa) {
+                const T t = T();
+                for (unsigned i = 0; i < count; i++) {
+                    scatterColumns(first + i, &t);
+                }
             } else {
-                auto* original = components;
-                components = reinterpret_cast<T*>(enlargeComponentsArray(
-                    components, sizeof(T), &componentsSize, entity + 1, false));
+                for (unsigned i = 0; i < count; i++) {
+                    new (componentPtr(first + i)) T();
+                }
+            }
+        } else {
+            if (type == ComponentType::POD) {
+                reserveComponents(0, EntityHandle::index(*std::max_element(
+                                      entities, entities + count, indexLess)) + 1);
+            }
+            for (unsigned i = 0; i < count; i++) {
+                const uint32_t index = EntityHandle::index(entities[i]);
+                if (type == ComponentType::Complex) {
+                    reserveComponents(index, index + 1);
+                }
+                new (componentPtr(index)) T();
+            }
+        }
+        addEntities(entities, count);
+    }
 
-                for (auto e : entityWithComponent) {
-                    new (&components[e]) T(original[e]);
-                    // components[e] = original[e];
+    void Delete(Entity entity) override {
+        if (storage != ComponentStorage::Direct) {
+            // keep components packed: move the last one in the freed slot
+            const uint32_t index = denseIndex(entity);
+            const uint32_t last = entityWithComponent.size() - 1;
+            if (index != InvalidDenseIndex && entityWithComponent[index] == entity) {
+                if (index != last) {
+                    if (storage == ComponentStorage::Soa)
+                        moveColumns(index, last);
+                    else
+                        *componentPtr(index) = std::move(*componentPtr(last));
+                }
+                if (type == ComponentType::Complex) {
+                    componentPtr(last)->~T();
                 }
-                free(original);
             }
+        } else if (type == ComponentType::Complex && hasComponent(entity)) {
+            componentPtr(EntityHandle::index(entity))->~T();
         }
-        new (&components[entity]) T();
-        addEntity(entity);
+        ComponentSystem::Delete(entity);
+    }
+
+    void DeleteMany(const Entity* entities, unsigned count) override {
+        // (ComponentSystem::DeleteMany goes through Delete for sparse storage
+        // or a single entity)
+        if (storage == ComponentStorage::Direct && type == ComponentType::Complex && count > 1) {
+            for (unsigned i = 0; i < count; i++) {
+                if (hasComponent(entities[i]))
+                    componentPtr(EntityHandle::index(entities[i]))->~T();
+            }
+        }
+        ComponentSystem::DeleteMany(entities, count);
     }
 
 #if SAC_DEBUG
@@ -166,12 +403,21 @@ template <typename T> class ComponentSystemImpl : public ComponentSystem {
             // in release only check if call expect a nullptr in case of failure
             !failIfNotfound;
 #endif
+        if (storage != ComponentStorage::Direct) {
+            // the lookup is needed anyway, so it doubles as the check
+            const uint32_t index = denseIndex(entity);
+            if (index != InvalidDenseIndex && entityWithComponent[index] == entity) {
+                return componentPtr(index);
+            }
+            check = true;
+        }
+
         if (check) {
             LOGF_IF(entity == 0,
                     "Requesting component of type '"
                         << INV_HASH(getId()) << "' [@ " << file << ':' << line
                         << "] for null entity (" << entity << ')');
-            if (!entityHasComponent(entityWithComponent, entity)) {
+            if (!hasComponent(entity)) {
                 if (failIfNotfound) {
                     LOGF("Entity '"
                          /*<< theEntityManager.entityName(entity)*/ << "' ("
@@ -183,27 +429,274 @@ template <typename T> class ComponentSystemImpl : public ComponentSystem {
                 return 0;
             }
         }
-        return &components[entity];
+        return componentPtr(EntityHandle::index(entity));
     }
 
     void forEachECDo(std::function<void(Entity, T*)> func) {
-        for (Entity e : entityWithComponent) { func(e, &components[e]); }
+        for (uint32_t i = 0; i < entityWithComponent.size(); i++) {
+            const Entity e = entityWithComponent[i];
+            func(e, componentPtr(componentIndex(i, e)));
+        }
+    }
+
+    // O(1) lookup without any logging, nullptr if entity has no component
+    T* tryGet(Entity entity) {
+        const uint32_t index = find(entity);
+        return (index == InvalidDenseIndex) ? 0 : componentPtr(index);
+    }
+    // same, for read-only access
+    const T* tryRead(Entity entity) const {
+        const uint32_t index = find(entity);
+        return (index == InvalidDenseIndex) ? 0 : componentPtr(index);
+    }
+
+    // component of the i-th entity of RetrieveAllEntityWithComponent()
+    T* componentAt(uint32_t i) {
+        return componentPtr(componentIndex(i, entityWithComponent[i]));
+    }
+    const T* readAt(uint32_t i) const {
+        return componentPtr(componentIndex(i, entityWithComponent[i]));
     }
 
-    void* componentAsVoidPtr(Entity e) { return Get(e, false); }
+    void* componentAsVoidPtr(Entity e) {
+        if (storage == ComponentStorage::Soa) {
+            // see storeComponent
+            return read(e, *soaCopy) ? soaCopy : 0;
+        }
+        return Get(e, false);
+    }
 
     uint8_t* saveComponent(Entity entity, uint8_t* out) {
         if (!out) {
             out = (uint8_t*)(new T); // new uint8_t[sizeof(T)];
         }
         T* t = (T*)out;
-        *t = *Get(entity);
+        const bool found = read(entity, *t);
+        LOGF_IF(!found, "Entity '" << entity << "' has no component of type '" << INV_HASH(getId()) << "'");
         return out;
     }
 
+    // Copies of the component, usable with any storage. read returns false
+    // if entity has no component.
+    bool read(Entity entity, T& out) const {
+        const uint32_t index = find(entity);
+        if (index == InvalidDenseIndex)
+            return false;
+        if (storage == ComponentStorage::Soa)
+            gatherColumns(index, &out);
+        else
+            out = *componentPtr(index);
+        return true;
+    }
+    void write(Entity entity, const T& in) {
+        const uint32_t index = find(entity);
+        LOGF_IF(index == InvalidDenseIndex, "Entity '" << entity << "' has no component of type '" << INV_HASH(getId()) << "'");
+        if (storage == ComponentStorage::Soa)
+            scatterColumns(index, &in);
+        else
+            *componentPtr(index) = in;
+    }
+
+    // Soa storage: one field of all components, in the order of
+    // RetrieveAllEntityWithComponent(). Adding components may move it.
+    template <typename F>
+    F* column(F T::*field) {
+        return reinterpret_cast<F*>(columnData(fieldOffset(field)));
+    }
+    template <typename F>
+    const F* column(F T::*field) const {
+        return reinterpret_cast<const F*>(columnData(fieldOffset(field)));
+    }
+    // Soa storage: one field of entity's component, or nullptr
+    template <typename F>
+    const F* readField(Entity entity, F T::*field) const {
+        const uint32_t index = find(entity);
+        return (index == InvalidDenseIndex) ? 0 : column(field) + index;
+    }
+
     protected:
+    // Soa storage: called by the constructor for every field of T (fields
+    // without a column aren't stored)
+    template <typename F>
+    void soaField(F T::*field) {
+        addColumn(fieldOffset(field), sizeof(F));
+    }
+    template <typename F>
+    static size_t fieldOffset(F T::*field) {
+        static const T t = T();
+        return reinterpret_cast<const uint8_t*>(&(t.*field)) - reinterpret_cast<const uint8_t*>(&t);
+    }
+
+    Entity ownerAt(uint32_t index) const {
+        return (storage != ComponentStorage::Direct) ? entityWithComponent[index] : directOwners[index];
+    }
+    // index of entity's component, or InvalidDenseIndex
+    uint32_t find(Entity entity) const {
+        uint32_t index;
+        if (storage != ComponentStorage::Direct) {
+            index = denseIndex(entity);
+            if (index == InvalidDenseIndex) return index;
+        } else {
+            index = EntityHandle::index(entity);
+            if (index >= directOwners.size()) return InvalidDenseIndex;
+        }
+        return (ownerAt(index) == entity) ? index : InvalidDenseIndex;
+    }
+
+    size_t compact() override {
+        size_t freed = ComponentSystem::compact();
+        if (storage == ComponentStorage::Soa) {
+            freed += shrinkColumns(std::max<uint32_t>(entityWithComponent.size(), 1u));
+        } else if (type == ComponentType::POD) {
+            uint32_t needed = entityWithComponent.size();
+            if (storage == ComponentStorage::Direct && !entityWithComponent.empty())
+                needed = EntityHandle::index(entityWithComponent.back()) + 1;
+            needed = std::max(needed, 1u);
+            if (needed < componentsSize) {
+                freed += (componentsSize - needed) * sizeof(T);
+                components = reinterpret_cast<T*>(shrinkComponentsArray(
+                    components, sizeof(T), &componentsSize, needed));
+            }
+        } else {
+            std::vector<bool> used(pages.size(), false);
+            for (uint32_t i = 0; i < entityWithComponent.size(); i++) {
+                used[componentIndex(i, entityWithComponent[i]) >> ComponentPageShift] = true;
+            }
+            for (uint32_t p = 0; p < pages.size(); p++) {
+                if (pages[p] && !used[p]) {
+                    free(pages[p]);
+                    pages[p] = 0;
+                    freed += ComponentPageSize * sizeof(T);
+                }
+            }
+            while (!pages.empty() && !pages.back()) pages.pop_back();
+            pages.shrink_to_fit();
+        }
+        return freed;
+    }
+
+    // make sure components [from, to) are allocated
+    void reserveComponents(uint32_t from, uint32_t to) {
+        if (storage == ComponentStorage::Soa) {
+            reserveColumns(to);
+            return;
+        }
+        if (type == ComponentType::POD) {
+            if (to <= componentsSize) return;
+            components = reinterpret_cast<T*>(enlargeComponentsArray(
+                components, sizeof(T), &componentsSize, to, true));
+            return;
+        }
+
+        // paged: existing components never move
+        const uint32_t last = (to - 1) >> ComponentPageShift;
+        if (last >= pages.size()) {
+            pages.resize(last + 1, 0);
+        }
+        for (uint32_t p = from >> ComponentPageShift; p <= last; p++) {
+            if (!pages[p]) {
+                pages[p] = reinterpret_cast<T*>(malloc(ComponentPageSize * sizeof(T)));
+            }
+        }
+    }
+
+    T* componentPtr(uint32_t index) const {
+#if SAC_DEBUG
+        LOGF_IF(storage == ComponentStorage::Soa,
+                INV_HASH(getId()) << "System components are stored as columns, use read/write/column");
+#endif
+        if (type == ComponentType::POD)
+            return &components[index];
+        return &pages[index >> ComponentPageShift][index & (ComponentPageSize - 1)];
+    }
+
+    // POD components: a single array, grown with realloc
     uint32_t componentsSize;
     T* components;
+    // Complex components: fixed size pages, so growing doesn't copy (nor
+    // invalidate) existing components
+    static const uint32_t ComponentPageShift = 7;
+    static const uint32_t ComponentPageSize = 1 << ComponentPageShift;
+    std::vector<T*> pages;
+    // Soa storage: copy handed out by componentAsVoidPtr
+    T* soaCopy;
+};
+
+// Join of several systems: entities having a component in all of them, with
+// their components. The smallest system drives the intersection, which is
+// computed once when the view is built; rows then hold component pointers so
+// iterating doesn't need any lookup:
+//
+//   View<PhysicsComponent, TransformationComponent> view(*this, theTransformationSystem);
+//   for (const auto& row: view) {
+//       PhysicsComponent* pc = row.get<0>();
+//       TransformationComponent* tc = row.get<1>();
+//
+// Use a const type for read-only components:
+//
+//   View<SpatialPartitionComponent, const TransformationComponent> view(*this, theTransformationSystem);
+//
+// Adding components to these systems invalidates the view. Rows are stored
+// in the frame arena (see FrameArena): views must not outlive the frame.
+template <typename T>
+struct ViewAccess {
+    static T* at(ComponentSystemImpl<T>& s, uint32_t i) { return s.componentAt(i); }
+    static T* find(ComponentSystemImpl<T>& s, Entity e) { return s.tryGet(e); }
+};
+template <typename T>
+struct ViewAccess<const T> {
+    static const T* at(ComponentSystemImpl<T>& s, uint32_t i) { return s.readAt(i); }
+    static const T* find(ComponentSystemImpl<T>& s, Entity e) { return s.tryRead(e); }
+};
+
+template <typename... T>
+class View {
+    public:
+    struct Row {
+        Entity entity;
+        std::tuple<T*...> components;
+
+        template <unsigned I>
+        typename std::tuple_element<I, std::tuple<T*...> >::type get() const {
+            return std::get<I>(components);
+        }
+    };
+
+    View(ComponentSystemImpl<typename std::remove_const<T>::type>&... systems) {
+        const std::vector<Entity>* lists[] = { &systems.RetrieveAllEntityWithComponent()... };
+        const std::vector<Entity>* driver = lists[0];
+        for (const auto* l: lists) {
+            if (l->size() < driver->size()) driver = l;
+        }
+
+        // driving system doesn't need a lookup
+        rows.reserve(driver->size());
+        for (uint32_t i = 0; i < driver->size(); i++) {
+            const Entity e = (*driver)[i];
+            add(e, (driver == &systems.RetrieveAllEntityWithComponent()
+                        ? ViewAccess<T>::at(systems, i)
+                        : ViewAccess<T>::find(systems, e))...);
+        }
+    }
+
+    typename FrameVector<Row>::const_iterator begin() const { return rows.begin(); }
+    typename FrameVector<Row>::const_iterator end() const { return rows.end(); }
+    size_t size() const { return rows.size(); }
+    const Row& operator[](size_t i) const { return rows[i]; }
+
+    private:
+    static bool allValid() { return true; }
+    template <typename H, typename... R>
+    static bool allValid(const H* h, const R*... r) { return h && allValid(r...); }
+
+    void add(Entity e, T*... c) {
+        if (allValid(c...)) {
+            Row row = { e, std::tuple<T*...>(c...) };
+            rows.push_back(row);
+        }
+    }
+
+    FrameVector<Row> rows;
 };
 
 #define INSTANCE_IMPL(T) T* T::_instance = 0;
@@ -238,12 +731,25 @@ template <typename T> class ComponentSystemImpl : public ComponentSystem {
         static type##System* _instance;
 
 #define FOR_EACH_COMPONENT(type, comp)                                         \
-    for (auto ________ent : entityWithComponent) {                             \
-        auto* comp = &components[________ent];
+    for (uint32_t ________i = 0; ________i < entityWithComponent.size();       \
+         ++________i) {                                                        \
+        auto* comp = componentPtr(componentIndex(                              \
+            ________i, entityWithComponent[________i]));
 
 #define FOR_EACH_ENTITY_COMPONENT(type, ent, comp)                             \
-    for (auto ent : entityWithComponent) {                                     \
-        auto* comp = &components[ent];
+    for (uint32_t ________i = 0; ________i < entityWithComponent.size();       \
+         ++________i) {                                                        \
+        const Entity ent = entityWithComponent[________i];                     \
+        auto* comp = componentPtr(componentIndex(________i, ent));
+
+// Only iterates over the entities of this update's time slice (see
+// ComponentSystem::UpdatePolicy): all of them unless the system is time-sliced
+#define FOR_EACH_ENTITY_COMPONENT_SLICED(type, ent, comp)                      \
+    for (uint32_t ________i = sliceBegin;                                      \
+         ________i < sliceEnd && ________i < entityWithComponent.size();       \
+         ++________i) {                                                        \
+        const Entity ent = entityWithComponent[________i];                     \
+        auto* comp = componentPtr(componentIndex(________i, ent));
 
 #define FOR_EACH_ENTITY(type, ent)                             \
     for (auto ent : entityWithComponent) {
@@ -43,7 +43,7 @@ const float TextComponent::RIGHT = 1.0f;
 const char InlineImageDelimiter[] = {(char)0xC3, (char)0x97};
 
 // Utility functions
-static Entity createRenderingEntity();
+static void createRenderingEntities(unsigned count, Entity* out);
 static void parseInlineImageString(const std::string& s, std::string* image, float* scale);
 static float computePartialStringWidth(TextComponent* trc, size_t from, size_t to, float charHeight, const TextSystem::FontDesc& fontDesc);
 static float computeStringWidth(TextComponent* trc, float charHeight, const TextSystem::FontDesc& fontDesc);
@@ -52,7 +52,7 @@ static float computeStartX(float stringWidth, const TextComponent* trc);
 // System implementation
 INSTANCE_IMPL(TextSystem);
 
-TextSystem::TextSystem() : ComponentSystemImpl<TextComponent>(HASH("Text", 0x5763c1af), ComponentType::Complex) {
+TextSystem::TextSystem() : ComponentSystemImpl<TextComponent>(HASH("Text", 0x5763c1af), ComponentType::Complex, 8, ComponentStorage::Sparse) {
     TextComponent tc;
     componentSerializer.add(new StringProperty(HASH("text", 0x4106ae4e), OFFSET(text, tc)));
     componentSerializer.add(new Property<hash_t>(HASH("font_name", 0x27b3eedc), OFFSET(fontName, tc)));
@@ -240,11 +240,13 @@ void TextSystem::DoUpdate(float dt) {
 
         // Add rendering entity if needed
         int missingCount = length - (renderingEntitiesPool.size() - letterCount);
-        for (int i=0; i <= missingCount; i++) {
-            renderingEntitiesPool.push_back(createRenderingEntity());
+        if (missingCount >= 0) {
+            const unsigned poolSize = renderingEntitiesPool.size();
+            renderingEntitiesPool.resize(poolSize + missingCount + 1);
+            createRenderingEntities(missingCount + 1, &renderingEntitiesPool[poolSize]);
         }
 
-        // Read TRANSFORM after potential calls to createRenderingEntity
+        // Read TRANSFORM after potential calls to createRenderingEntities
         // Otherwise trans ptr might become invalid
         const TransformationComponent* trans = TRANSFORM(entity);
 
@@ -480,9 +482,8 @@ relayout:
     END_FOR_EACH()
 
     if (renderingEntitiesPool.size() > letterCount*2) {
-        for (unsigned i=letterCount*2; i<renderingEntitiesPool.size(); i++) {
-            theEntityManager.DeleteEntity(renderingEntitiesPool[i]);
-        }
+        theEntityManager.DeleteEntities(&renderingEntitiesPool[letterCount*2],
+            renderingEntitiesPool.size() - letterCount*2);
         renderingEntitiesPool.resize(letterCount*2);
     }
     for (unsigned i=letterCount; i<renderingEntitiesPool.size(); i++) {
@@ -549,12 +550,10 @@ void TextSystem::Delete(Entity e) {
     ComponentSystemImpl<TextComponent>::Delete(e);
 }
 
-static Entity createRenderingEntity() {
-    Entity e = theEntityManager.CreateEntity(HASH("__/text_letter", 0x1fca5927));
-    ADD_COMPONENT(e, Transformation);
-    ADD_COMPONENT(e, Rendering);
-    // ADD_COMPONENT(e, Anchor);
-    return e;
+static void createRenderingEntities(unsigned count, Entity* out) {
+    theEntityManager.CreateEntities(count, out, HASH("__/text_letter", 0x1fca5927));
+    theEntityManager.AddComponentToEntities(out, count,
+        { &theTransformationSystem, &theRenderingSystem });
 }
 
 static void parseInlineImageString(const std::string& s, std::string* image, float* scale) {
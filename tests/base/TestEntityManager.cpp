@@ -25,6 +25,7 @@
 #include <glm/gtc/random.hpp>
 
 #include <base/EntityManager.h>
+#include <algorithm>
 #include "systems/TransformationSystem.h"
 #include "systems/ADSRSystem.h"
 
@@ -86,4 +87,248 @@ namespace {
 
         delete[] dump;
     }
+
+    TEST_FIXTURE(TestSetup, ComponentSignature)
+    {
+        const ComponentSignature t = theTransformationSystem.getSignature();
+        const ComponentSignature a = theADSRSystem.getSignature();
+        CHECK(t != a);
+
+        Entity e = theEntityManager.CreateEntity(0);
+        CHECK_EQUAL((ComponentSignature)0, theEntityManager.signature(e));
+        ADD_COMPONENT(e, Transformation);
+        CHECK(theEntityManager.hasComponents(e, t));
+        CHECK(!theEntityManager.hasComponents(e, t | a));
+        ADD_COMPONENT(e, ADSR);
+        CHECK(theEntityManager.hasComponents(e, t | a));
+        theEntityManager.RemoveComponent(e, &theTransformationSystem);
+        CHECK(!theEntityManager.hasComponents(e, t));
+        CHECK(!theTransformationSystem.hasComponent(e));
+        CHECK(theEntityManager.hasComponents(e, a));
+
+        CHECK_EQUAL(1u, theEntityManager.entityCount());
+        theEntityManager.DeleteEntity(e);
+        CHECK_EQUAL(0u, theEntityManager.entityCount());
+        CHECK(!theADSRSystem.hasComponent(e));
+    }
+
+    TEST_FIXTURE(TestSetup, BulkCreateAddDelete)
+    {
+        Entity single = theEntityManager.CreateEntity(0);
+        ADD_COMPONENT(single, Transformation);
+        TRANSFORM(single)->z = 0.5f;
+
+        Entity entities[20];
+        theEntityManager.CreateEntities(20, entities, 0, EntityType::Persistent);
+        theEntityManager.AddComponentToEntities(entities, 20,
+            { &theTransformationSystem, &theADSRSystem });
+        CHECK_EQUAL(21u, theEntityManager.entityCount());
+        CHECK_EQUAL(21u, theTransformationSystem.entityCount());
+        for (int i=0; i<20; i++) {
+            CHECK(theEntityManager.hasComponents(entities[i],
+                theTransformationSystem.getSignature() | theADSRSystem.getSignature()));
+            TRANSFORM(entities[i])->z = i;
+        }
+
+        // delete every other entity, in non sorted order
+        Entity odd[10];
+        for (int i=0; i<10; i++) odd[i] = entities[19 - 2 * i];
+        theEntityManager.DeleteEntities(odd, 10);
+        CHECK_EQUAL(11u, theEntityManager.entityCount());
+        CHECK_EQUAL(11u, theTransformationSystem.entityCount());
+        CHECK_EQUAL(10u, theADSRSystem.entityCount());
+        for (int i=0; i<20; i++) {
+            CHECK_EQUAL(i % 2 == 0, theTransformationSystem.hasComponent(entities[i]));
+            CHECK_EQUAL(i % 2 == 0, theADSRSystem.hasComponent(entities[i]));
+        }
+        CHECK_EQUAL(0.5f, TRANSFORM(single)->z);
+        for (Entity e: theTransformationSystem.RetrieveAllEntityWithComponent()) {
+            CHECK(e == single || TRANSFORM(e)->z == (float)(e - entities[0]));
+        }
+
+        // deleted slots get recycled
+        Entity recycled[10];
+        theEntityManager.CreateEntities(10, recycled, 0);
+        for (int i=0; i<10; i++) {
+            CHECK(std::find_if(odd, odd + 10, [&recycled, i] (Entity o) {
+                return EntityHandle::index(o) == EntityHandle::index(recycled[i]);
+            }) != odd + 10);
+            CHECK_EQUAL((ComponentSignature)0, theEntityManager.signature(recycled[i]));
+        }
+    }
+
+    TEST_FIXTURE(TestSetup, StaleHandles)
+    {
+        Entity e = theEntityManager.CreateEntity(0);
+        ADD_COMPONENT(e, Transformation);
+        CHECK(theEntityManager.isAlive(e));
+        theEntityManager.DeleteEntity(e);
+        CHECK(!theEntityManager.isAlive(e));
+
+        // slot is reused, with a new generation
+        Entity f = theEntityManager.CreateEntity(0);
+        ADD_COMPONENT(f, Transformation);
+        CHECK_EQUAL(EntityHandle::index(e), EntityHandle::index(f));
+        CHECK(e != f);
+        CHECK(!theEntityManager.isAlive(e));
+        CHECK(theEntityManager.isAlive(f));
+        CHECK_EQUAL((ComponentSignature)0, theEntityManager.signature(e));
+        CHECK(!theTransformationSystem.hasComponent(e));
+        CHECK(theTransformationSystem.Get(e, false) == 0);
+        CHECK(theTransformationSystem.Get(f, false) != 0);
+
+        // still invalid after a reset
+        theEntityManager.deleteAllEntities();
+        Entity g = theEntityManager.CreateEntity(0);
+        CHECK(g != e && g != f);
+        CHECK(!theEntityManager.isAlive(f));
+        CHECK(theEntityManager.isAlive(g));
+    }
+
+    TEST_FIXTURE(TestSetup, GetEntityByName)
+    {
+        const hash_t foo = Murmur::RuntimeHash("foo");
+        const hash_t bar = Murmur::RuntimeHash("bar");
+        Entity unnamed = theEntityManager.CreateEntity(0);
+        Entity a = theEntityManager.CreateEntity(foo);
+        Entity b = theEntityManager.CreateEntity(bar);
+        CHECK_EQUAL(a, theEntityManager.getEntityByName(foo));
+        CHECK_EQUAL(b, theEntityManager.getEntityByName(bar));
+        CHECK_EQUAL((Entity)0, theEntityManager.getEntityByName(Murmur::RuntimeHash("baz")));
+        CHECK_EQUAL((Entity)0, theEntityManager.getEntityByName(0));
+        CHECK_EQUAL(1u, theEntityManager.entityCountWithName(foo));
+
+        // shared name: lowest index wins, all are reported
+        Entity bulk[3];
+        theEntityManager.CreateEntities(3, bulk, foo);
+        CHECK_EQUAL(4u, theEntityManager.entityCountWithName(foo));
+        CHECK_EQUAL(a, theEntityManager.getEntityByName(foo));
+        std::vector<Entity> all = theEntityManager.getEntitiesByName(foo);
+        CHECK_EQUAL(4u, all.size());
+        CHECK_EQUAL(a, all[0]);
+
+        theEntityManager.DeleteEntity(a);
+        CHECK_EQUAL(bulk[0], theEntityManager.getEntityByName(foo));
+        theEntityManager.DeleteEntities(bulk, 3);
+        CHECK_EQUAL((Entity)0, theEntityManager.getEntityByName(foo));
+        CHECK_EQUAL(0u, theEntityManager.entityCountWithName(foo));
+
+        // reused slot gets the new name only
+        Entity c = theEntityManager.CreateEntity(bar);
+        CHECK_EQUAL(2u, theEntityManager.entityCountWithName(bar));
+        CHECK_EQUAL(b, theEntityManager.getEntityByName(bar));
+        theEntityManager.DeleteEntity(b);
+        CHECK_EQUAL(c, theEntityManager.getEntityByName(bar));
+        theEntityManager.DeleteEntity(unnamed);
+
+        theEntityManager.deleteAllEntities();
+        CHECK_EQUAL((Entity)0, theEntityManager.getEntityByName(bar));
+    }
+
+    TEST_FIXTURE(TestSetup, DeferredCommands)
+    {
+        Entity e[4];
+        theEntityManager.CreateEntities(4, e, 0);
+        ADD_COMPONENT(e[0], Transformation);
+
+        // record while iterating, storage is untouched until flush
+        for (Entity a: theTransformationSystem.RetrieveAllEntityWithComponent()) {
+            theEntityManager.deferred.DeleteEntity(a);
+            theEntityManager.deferred.AddComponent(e[1], &theTransformationSystem);
+            theEntityManager.deferred.AddComponent(e[2], &theTransformationSystem);
+            theEntityManager.deferred.AddComponent(e[2], &theADSRSystem);
+        }
+        theEntityManager.deferred.RemoveComponent(e[2], &theADSRSystem);
+        theEntityManager.deferred.AddComponent(e[3], &theADSRSystem);
+        theEntityManager.deferred.DeleteEntity(e[3]);
+        Entity f = theEntityManager.deferred.CreateEntity(0);
+        theEntityManager.deferred.AddComponent(f, &theADSRSystem);
+
+        CHECK(theEntityManager.isAlive(e[0]));
+        CHECK(theEntityManager.isAlive(f));
+        CHECK_EQUAL(1u, theTransformationSystem.entityCount());
+        CHECK_EQUAL(0u, theADSRSystem.entityCount());
+        CHECK(!theEntityManager.deferred.empty());
+
+        theEntityManager.deferred.flush();
+        CHECK(theEntityManager.deferred.empty());
+        CHECK(!theEntityManager.isAlive(e[0]));
+        CHECK(!theEntityManager.isAlive(e[3]));
+        CHECK_EQUAL(theTransformationSystem.getSignature(), theEntityManager.signature(e[1]));
+        CHECK_EQUAL(theTransformationSystem.getSignature(), theEntityManager.signature(e[2]));
+        CHECK_EQUAL(theADSRSystem.getSignature(), theEntityManager.signature(f));
+        CHECK_EQUAL(2u, theTransformationSystem.entityCount());
+        CHECK_EQUAL(1u, theADSRSystem.entityCount());
+
+        // commands on deleted entities are dropped
+        theEntityManager.deferred.AddComponent(e[1], &theADSRSystem);
+        theEntityManager.deferred.DeleteEntity(e[1]);
+        theEntityManager.deferred.DeleteEntity(e[1]);
+        theEntityManager.DeleteEntity(f);
+        theEntityManager.deferred.DeleteEntity(f);
+        theEntityManager.deferred.flush();
+        CHECK(!theEntityManager.isAlive(e[1]));
+        CHECK_EQUAL(0u, theADSRSystem.entityCount());
+        CHECK_EQUAL(1u, theEntityManager.entityCount());
+    }
+
+    TEST_FIXTURE(TestSetup, Compaction)
+    {
+        const int N = 5000;
+        std::vector<Entity> entities(N);
+        theEntityManager.CreateEntities(N, entities.data(), 0);
+        theEntityManager.AddComponentToEntities(entities.data(), N, { &theTransformationSystem });
+        TRANSFORM(entities[10])->z = 0.25f;
+
+        // keep a few low entities
+        theEntityManager.DeleteEntities(&entities[20], N - 20);
+        theEntityManager.DeleteEntity(entities[5]);
+        CHECK(theEntityManager.compact() > 0);
+        CHECK_EQUAL(19u, theEntityManager.entityCount());
+        CHECK_EQUAL(0.25f, TRANSFORM(entities[10])->z);
+        CHECK(!theEntityManager.isAlive(entities[30]));
+        // nothing left to reclaim
+        CHECK_EQUAL((size_t)0, theEntityManager.compact());
+
+        // free slots are reused lowest first
+        Entity e = theEntityManager.CreateEntity(0);
+        CHECK_EQUAL(EntityHandle::index(entities[5]), EntityHandle::index(e));
+        e = theEntityManager.CreateEntity(0);
+        CHECK_EQUAL(EntityHandle::index(entities[19]) + 1, EntityHandle::index(e));
+        ADD_COMPONENT(e, Transformation);
+        CHECK(TRANSFORM(e) != 0);
+
+        // automatic mode
+        theEntityManager.setAutoCompaction(0.5f);
+        theEntityManager.CreateEntities(N, entities.data(), 0);
+        theEntityManager.autoCompact();
+        CHECK_EQUAL((unsigned)N + 21, theEntityManager.entityCount());
+        theEntityManager.DeleteEntities(entities.data(), N);
+        theEntityManager.autoCompact();
+        e = theEntityManager.CreateEntity(0);
+        CHECK(EntityHandle::index(e) < 30);
+    }
+
+    TEST_FIXTURE(TestSetup, CreateAddDeleteOneByOne)
+    {
+        const int N = 1000;
+        std::vector<Entity> entities(N);
+
+        for (int i = 0; i < N; i++) {
+            entities[i] = theEntityManager.CreateEntity(0);
+        }
+        for (int i = 0; i < N; i++) {
+            theEntityManager.AddComponent(entities[i], &theTransformationSystem);
+            theEntityManager.AddComponent(entities[i], &theADSRSystem);
+        }
+        CHECK_EQUAL((unsigned)N, theEntityManager.entityCount());
+        CHECK_EQUAL((unsigned)N, theTransformationSystem.entityCount());
+        CHECK_EQUAL((unsigned)N, theADSRSystem.entityCount());
+        for (int i = N - 1; i >= 0; i--) {
+            theEntityManager.DeleteEntity(entities[i]);
+        }
+        CHECK_EQUAL(0u, theEntityManager.entityCount());
+        CHECK_EQUAL(0u, theTransformationSystem.entityCount());
+        CHECK_EQUAL(0u, theADSRSystem.entityCount());
+    }
 }
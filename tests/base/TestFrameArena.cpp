@@ -0,0 +1,196 @@
+/*
+    This file is part of Soupe Au Caillou.
+
+    @author Soupe au Caillou - Jordane Pelloux-Prayer
+    @author Soupe au Caillou - Gautier Pelloux-Prayer
+    @author Soupe au Caillou - Pierre-Eric Pelloux-Prayer
+
+    Soupe Au Caillou is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3.
+
+    Soupe Au Caillou is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Soupe Au Caillou.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#include <UnitTest++.h>
+
+#include "base/FrameArena.h"
+#include "systems/AnchorSystem.h"
+#include "systems/BackInTimeSystem.h"
+#include "systems/CameraSystem.h"
+#include "systems/CollisionSystem.h"
+#include "systems/ParticuleSystem.h"
+#include "systems/PhysicsSystem.h"
+#include "systems/RenderingSystem.h"
+#include "systems/SpatialPartitionSystem.h"
+#include "systems/TransformationSystem.h"
+#include "util/Random.h"
+
+#include "tests_utils.h"
+#include "tools/bench/AllocationCounter.h"
+
+TEST(FrameArenaAlignment) {
+    FrameArena arena(1024);
+    for (size_t align = 1; align <= 64; align *= 2) {
+        arena.allocate(3, 1);
+        void* p = arena.allocate(10, align);
+        CHECK_EQUAL(0u, reinterpret_cast<uintptr_t>(p) % align);
+    }
+    double* d = arena.allocate<double>(4);
+    CHECK_EQUAL(0u, reinterpret_cast<uintptr_t>(d) % alignof(double));
+}
+
+TEST(FrameArenaResetAndRelease) {
+    FrameArena arena(1024);
+    arena.allocate(100);
+    const size_t used = arena.used();
+    void* p = arena.allocate(50, 1);
+    CHECK_EQUAL(used + 50, arena.used());
+
+    // latest allocation can be given back, older ones can't
+    arena.release(p, 50);
+    CHECK_EQUAL(used, arena.used());
+    arena.allocate(50, 1);
+    arena.allocate(10, 1);
+    arena.release(p, 50);
+    CHECK_EQUAL(used + 60, arena.used());
+
+    arena.reset();
+    CHECK_EQUAL(0u, arena.used());
+    CHECK_EQUAL(1024u, arena.capacity());
+}
+
+TEST(FrameArenaGrowsThenMerges) {
+    FrameArena arena(1024);
+    auto frame = [&arena] () {
+        for (int i = 0; i < 10; i++)
+            arena.allocate(500);
+    };
+    frame();
+    const size_t grown = arena.capacity();
+    CHECK(grown > 1024u);
+
+    // blocks are merged: the same frame now fits in a single block
+    arena.reset();
+    CHECK_EQUAL(grown, arena.capacity());
+    frame();
+    CHECK_EQUAL(grown, arena.capacity());
+}
+
+TEST(FrameVectorUsesArena) {
+    FrameArena arena(4096);
+    {
+        FrameVector<int> v((FrameAllocator<int>(arena)));
+        for (int i = 0; i < 100; i++)
+            v.push_back(i);
+        CHECK_EQUAL(99, v.back());
+        // growing reuses the latest allocation
+        CHECK(arena.used() < 2 * 128 * sizeof(int));
+    }
+    CHECK_EQUAL(&FrameArena::current(), FrameAllocator<int>().arena);
+}
+
+namespace {
+    struct SteadyStateSetup : public NeedsEntityManager {
+        SteadyStateSetup() : NeedsEntityManager() {
+            Random::Init(1);
+            TransformationSystem::CreateInstance();
+            AnchorSystem::CreateInstance();
+            RenderingSystem::CreateInstance();
+            CameraSystem::CreateInstance();
+            PhysicsSystem::CreateInstance();
+            BackInTimeSystem::CreateInstance();
+            SpatialPartitionSystem::CreateInstance();
+            CollisionSystem::CreateInstance();
+            ParticuleSystem::CreateInstance();
+        }
+        ~SteadyStateSetup() {
+            uninit();
+            ParticuleSystem::DestroyInstance();
+            CollisionSystem::DestroyInstance();
+            SpatialPartitionSystem::DestroyInstance();
+            BackInTimeSystem::DestroyInstance();
+            PhysicsSystem::DestroyInstance();
+            CameraSystem::DestroyInstance();
+            RenderingSystem::DestroyInstance();
+            AnchorSystem::DestroyInstance();
+            TransformationSystem::DestroyInstance();
+        }
+    };
+}
+
+TEST_FIXTURE(SteadyStateSetup, SteadyStateFrameDoesNotAllocate) {
+    Entity camera = theEntityManager.CreateEntity(HASH("camera", 0x526b9e0c));
+    ADD_COMPONENT(camera, Transformation);
+    ADD_COMPONENT(camera, Camera);
+    TRANSFORM(camera)->size = glm::vec2(20, 12);
+    CAMERA(camera)->enable = true;
+
+    // emitter with a constant particule count
+    Entity emitter = theEntityManager.CreateEntity(HASH("emitter", 0x60240407));
+    ADD_COMPONENT(emitter, Transformation);
+    ADD_COMPONENT(emitter, Particule);
+    ParticuleComponent* pc = PARTICULE(emitter);
+    pc->emissionRate = 300;
+    pc->duration = -1;
+    pc->lifetime = Interval<float>(0.5f);
+    pc->initialColor = pc->finalColor = Interval<Color>(Color(1, 1, 1, 1));
+    pc->initialSize = Interval<float>(0.1f, 0.2f);
+    pc->mass = 1;
+
+    // colliding movers, going back and forth
+    std::vector<Entity> movers;
+    for (int i = 0; i < 50; i++) {
+        Entity e = theEntityManager.CreateEntity(HASH("mover", 0x1c79aa8));
+        ADD_COMPONENT(e, Transformation);
+        ADD_COMPONENT(e, Rendering);
+        ADD_COMPONENT(e, Physics);
+        ADD_COMPONENT(e, BackInTime);
+        ADD_COMPONENT(e, SpatialPartition);
+        ADD_COMPONENT(e, Collision);
+        TRANSFORM(e)->position = glm::vec2(-5 + (i % 10), -2 + (i / 10));
+        TRANSFORM(e)->size = glm::vec2(0.8f);
+        RENDERING(e)->show = true;
+        PHYSICS(e)->mass = 1;
+        COLLISION(e)->group = COLLISION(e)->collideWith = 1;
+        movers.push_back(e);
+    }
+
+    ComponentSystem* systems[] = {
+        &theParticuleSystem, &thePhysicsSystem, &theSpatialPartitionSystem,
+        &theCollisionSystem, &theBackInTimeSystem,
+#if ! SAC_INGAME_EDITORS
+        // in-game editors need a GL context
+        &theRenderingSystem,
+#endif
+    };
+    auto frame = [&] (int index) {
+        const float vx = ((index / 30) % 2) ? 1.0f : -1.0f;
+        for (unsigned i = 0; i < movers.size(); i++) {
+            PHYSICS(movers[i])->linearVelocity = glm::vec2(vx * (i % 3), 0.0f);
+        }
+        ComponentSystem::NextVersion();
+        for (auto* s: systems) {
+            s->Update(1 / 60.0f);
+        }
+        theEntityManager.deferred.flush();
+        FrameArena::ResetAll();
+    };
+
+    int index = 0;
+    for (; index < 120; index++)
+        frame(index);
+
+    const unsigned long before = AllocationCounter::count();
+    for (; index < 240; index++)
+        frame(index);
+    CHECK_EQUAL(0u, AllocationCounter::count() - before);
+}
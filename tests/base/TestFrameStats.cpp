@@ -0,0 +1,82 @@
+/*
+    This file is part of Soupe Au Caillou.
+
+    @author Soupe au Caillou - Jordane Pelloux-Prayer
+    @author Soupe au Caillou - Gautier Pelloux-Prayer
+    @author Soupe au Caillou - Pierre-Eric Pelloux-Prayer
+
+    Soupe Au Caillou is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3.
+
+    Soupe Au Caillou is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Soupe Au Caillou.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <UnitTest++.h>
+
+#include "base/FrameStats.h"
+
+#include <sstream>
+#include <thread>
+#include <vector>
+
+TEST(DurationHistogramPercentiles)
+{
+    DurationHistogram h;
+    CHECK_EQUAL(0u, h.count());
+    CHECK_EQUAL(0, h.percentile(50));
+
+    // 1ms .. 100ms
+    for (int i=1; i<=100; i++) {
+        h.add(i / 1000.0f);
+    }
+    CHECK_EQUAL(100u, h.count());
+    CHECK_CLOSE(0.0505f, h.mean(), 0.0001f);
+    CHECK_CLOSE(0.1f, h.max(), 0.0001f);
+    // upper bound of the bucket, 0.1ms wide
+    CHECK_CLOSE(0.0501f, h.percentile(50), 0.00005f);
+    CHECK_CLOSE(0.0951f, h.percentile(95), 0.00005f);
+    // beyond the last bucket: max
+    CHECK_CLOSE(0.1f, h.percentile(100), 0.00005f);
+
+    h.reset();
+    CHECK_EQUAL(0u, h.count());
+    CHECK_EQUAL(0, h.max());
+}
+
+TEST(DurationHistogramConcurrentAdds)
+{
+    DurationHistogram h;
+    std::vector<std::thread> threads;
+    for (int t=0; t<4; t++) {
+        threads.push_back(std::thread([&h, t] () {
+            for (int i=0; i<10000; i++) h.add((t + 1) / 1000.0f);
+        }));
+    }
+    for (auto& th: threads) th.join();
+
+    CHECK_EQUAL(40000u, h.count());
+    CHECK_CLOSE(0.004f, h.max(), 0.00001f);
+    CHECK_CLOSE(0.0025f, h.mean(), 0.00001f);
+    CHECK_EQUAL(10000u, h.bucket(10));
+}
+
+TEST(FrameStatsReport)
+{
+    FrameStats stats;
+    stats.steps[FrameStep::Update].add(0.004f);
+    stats.steps[FrameStep::Render].add(0.002f);
+    stats.droppedUpdates += 3;
+
+    std::stringstream out;
+    stats.report(out);
+    CHECK(out.str().find("update: 1 frames") != std::string::npos);
+    CHECK(out.str().find("wait: 0 frames") != std::string::npos);
+    CHECK(out.str().find("dropped updates: 3") != std::string::npos);
+}
@@ -0,0 +1,132 @@
+/*
+    This file is part of Soupe Au Caillou.
+
+    @author Soupe au Caillou - Jordane Pelloux-Prayer
+    @author Soupe au Caillou - Gautier Pelloux-Prayer
+    @author Soupe au Caillou - Pierre-Eric Pelloux-Prayer
+
+    Soupe Au Caillou is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3.
+
+    Soupe Au Caillou is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Soupe Au Caillou.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <UnitTest++.h>
+
+#include "base/JobSystem.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+TEST(JobSystemRunsEveryRange)
+{
+    for (unsigned workers = 0; workers < 4; workers += 3) {
+        JobSystem jobs;
+        jobs.setWorkerCount(workers);
+
+        std::vector<int> touched(1000, 0);
+        jobs.parallelFor(0, touched.size(), 64, [&touched] (unsigned first, unsigned last) {
+            for (unsigned i=first; i<last; i++) touched[i]++;
+        });
+        for (unsigned i=0; i<touched.size(); i++) {
+            CHECK_EQUAL(1, touched[i]);
+        }
+    }
+}
+
+TEST(JobSystemWorkersStealJobs)
+{
+    JobSystem jobs;
+    jobs.setWorkerCount(3);
+
+    std::atomic<int> done(0);
+    std::vector<std::thread::id> threads(16);
+    JobSystem::Counter counter;
+    for (unsigned i=0; i<threads.size(); i++) {
+        jobs.run([&done, &threads, i] () {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            threads[i] = std::this_thread::get_id();
+            done++;
+        }, &counter);
+    }
+    jobs.wait(counter);
+    CHECK(counter.done());
+    CHECK_EQUAL(16, done.load());
+
+    // every job was queued by this thread: other ones took some
+    bool stolen = false;
+    for (auto& t: threads) {
+        stolen |= (t != std::this_thread::get_id());
+    }
+    CHECK(stolen);
+}
+
+TEST(JobSystemDependencies)
+{
+    for (unsigned workers = 0; workers < 3; workers += 2) {
+        JobSystem jobs;
+        jobs.setWorkerCount(workers);
+
+        std::atomic<int> step(0);
+        int first = -1, second = -1, third = -1;
+        JobSystem::Counter a, b, all;
+        jobs.run([&] () {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            first = step++;
+        }, &a);
+        jobs.run([&] () { second = step++; }, &b, &a);
+        jobs.run([&] () { third = step++; }, &all, &b);
+        jobs.wait(all);
+
+        CHECK_EQUAL(0, first);
+        CHECK_EQUAL(1, second);
+        CHECK_EQUAL(2, third);
+    }
+}
+
+TEST(JobSystemNestedWait)
+{
+    // a job waiting for its own jobs runs them instead of blocking a worker
+    JobSystem jobs;
+    jobs.setWorkerCount(1);
+
+    std::atomic<int> count(0);
+    JobSystem::Counter outer;
+    for (int i=0; i<4; i++) {
+        jobs.run([&jobs, &count] () {
+            jobs.parallelFor(0, 100, 10, [&count] (unsigned first, unsigned last) {
+                count += last - first;
+            });
+        }, &outer);
+    }
+    jobs.wait(outer);
+    CHECK_EQUAL(400, count.load());
+}
+
+TEST(JobSystemWaitsForHeldCounter)
+{
+    // nothing to run: the waiting thread sleeps until the counter is released
+    JobSystem jobs;
+    jobs.setWorkerCount(1);
+
+    JobSystem::Counter counter, after;
+    std::atomic<int> ran(0);
+    jobs.hold(counter);
+    jobs.run([&ran] () { ran++; }, &after, &counter);
+    std::thread other([&jobs, &counter] () {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        jobs.release(counter);
+    });
+    jobs.wait(after);
+    CHECK(counter.done());
+    CHECK_EQUAL(1, ran.load());
+    other.join();
+}
@@ -0,0 +1,202 @@
+/*
+    This file is part of Soupe Au Caillou.
+
+    @author Soupe au Caillou - Jordane Pelloux-Prayer
+    @author Soupe au Caillou - Gautier Pelloux-Prayer
+    @author Soupe au Caillou - Pierre-Eric Pelloux-Prayer
+
+    Soupe Au Caillou is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3.
+
+    Soupe Au Caillou is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Soupe Au Caillou.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <UnitTest++.h>
+
+#include "base/SystemScheduler.h"
+#include "systems/System.h"
+#include "tests_utils.h"
+
+#include <atomic>
+#include <thread>
+
+namespace {
+    struct DummyComponent {
+        int value;
+    };
+
+    std::atomic<int> updateCounter;
+
+    class DummySystem : public ComponentSystemImpl<DummyComponent> {
+        public:
+        DummySystem(hash_t id) : ComponentSystemImpl<DummyComponent>(id), start(-1), end(-1), updates(0), dt(0), exclusive(false) {}
+        DummySystem(hash_t id, std::initializer_list<hash_t> r, std::initializer_list<hash_t> w)
+            : ComponentSystemImpl<DummyComponent>(id), start(-1), end(-1), updates(0), dt(0), exclusive(false) {
+            declareAccesses(r, w);
+        }
+
+        bool needsExclusiveUpdate() const override {
+            return exclusive || ComponentSystemImpl<DummyComponent>::needsExclusiveUpdate();
+        }
+
+        void DoUpdate(float pDt) override {
+            start = updateCounter++;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            end = updateCounter++;
+            thread = std::this_thread::get_id();
+            updates++;
+            dt = pDt;
+        }
+
+        void setPeriod(unsigned period, unsigned phase) {
+            UpdatePolicy p;
+            p.period = period;
+            p.phase = phase;
+            setUpdatePolicy(p);
+        }
+
+        int start, end, updates;
+        float dt;
+        std::thread::id thread;
+        bool exclusive;
+    };
+
+    hash_t id(const char* name) {
+        return Murmur::RuntimeHash((std::string("SchedulerTest_") + name).c_str());
+    }
+
+    // a reads b, c writes a, d independent, e undeclared, f independent
+    struct TestSetup {
+        TestSetup() :
+            a(id("a"), { id("b") }, {}),
+            b(id("b"), {}, {}),
+            c(id("c"), {}, { id("a") }),
+            d(id("d"), {}, {}),
+            e(id("e")),
+            f(id("f"), {}, {}),
+            scheduler(jobs) {
+            systems = { &b, &a, &c, &d, &e, &f };
+            scheduler.build(systems);
+            updateCounter = 0;
+        }
+
+        DummySystem a, b, c, d, e, f;
+        std::vector<ComponentSystem*> systems;
+        JobSystem jobs;
+        SystemScheduler scheduler;
+    };
+
+    TEST_FIXTURE(TestSetup, SchedulerDependencies)
+    {
+        CHECK(SystemScheduler::conflict(&a, &b));
+        CHECK(SystemScheduler::conflict(&a, &c));
+        CHECK(!SystemScheduler::conflict(&b, &c));
+        CHECK(!SystemScheduler::conflict(&a, &d));
+        CHECK(SystemScheduler::conflict(&d, &e));
+
+        CHECK_EQUAL(0u, scheduler.dependencies(0).size());
+        // a -> b
+        CHECK_EQUAL(1u, scheduler.dependencies(1).size());
+        CHECK_EQUAL(0u, scheduler.dependencies(1)[0]);
+        // c -> a
+        CHECK_EQUAL(1u, scheduler.dependencies(2).size());
+        CHECK_EQUAL(1u, scheduler.dependencies(2)[0]);
+        CHECK_EQUAL(0u, scheduler.dependencies(3).size());
+        // e -> everything not already depended on
+        CHECK_EQUAL(2u, scheduler.dependencies(4).size());
+        CHECK_EQUAL(2u, scheduler.dependencies(4)[0]);
+        CHECK_EQUAL(3u, scheduler.dependencies(4)[1]);
+        CHECK_EQUAL(1u, scheduler.dependencies(5).size());
+        CHECK_EQUAL(4u, scheduler.dependencies(5)[0]);
+    }
+
+    TEST_FIXTURE(TestSetup, SchedulerSequentialUpdate)
+    {
+        scheduler.update(0.016f);
+        for (unsigned i=0; i<systems.size(); i++) {
+            const DummySystem* s = static_cast<DummySystem*>(systems[i]);
+            CHECK_EQUAL((int)i * 2, s->start);
+            CHECK(s->thread == std::this_thread::get_id());
+        }
+    }
+
+    TEST_FIXTURE(TestSetup, SchedulerParallelUpdate)
+    {
+        jobs.setWorkerCount(3);
+        for (int frame=0; frame<10; frame++) {
+            updateCounter = 0;
+            scheduler.update(0.016f);
+            CHECK_EQUAL((int)systems.size() * 2, updateCounter.load());
+
+            CHECK(b.end < a.start);
+            CHECK(a.end < c.start);
+            CHECK(c.end < e.start);
+            CHECK(d.end < e.start);
+            CHECK(e.end < f.start);
+            // undeclared systems are updated alone on the game thread
+            CHECK(e.thread == std::this_thread::get_id());
+            CHECK_EQUAL(e.start + 1, e.end);
+        }
+        jobs.setWorkerCount(0);
+    }
+
+    TEST_FIXTURE(TestSetup, SchedulerExclusiveUpdate)
+    {
+        // d declares its accesses, but asks to be updated alone this time
+        jobs.setWorkerCount(3);
+        d.exclusive = true;
+        for (int frame=0; frame<10; frame++) {
+            updateCounter = 0;
+            scheduler.update(0.016f);
+            CHECK(d.thread == std::this_thread::get_id());
+            CHECK_EQUAL(d.start + 1, d.end);
+            for (auto* s: systems) {
+                const DummySystem* other = static_cast<DummySystem*>(s);
+                if (other != &d)
+                    CHECK(other->end < d.start || other->start > d.end);
+            }
+        }
+        jobs.setWorkerCount(0);
+    }
+
+    TEST_FIXTURE(TestSetup, SchedulerUpdatePeriods)
+    {
+        for (unsigned workers = 0; workers < 4; workers += 3) {
+            jobs.setWorkerCount(workers);
+            a.setPeriod(2, 1);
+            d.setPeriod(3, 0);
+            for (auto* s: systems) static_cast<DummySystem*>(s)->updates = 0;
+
+            for (int frame=0; frame<6; frame++) {
+                updateCounter = 0;
+                a.start = a.end = -1;
+                scheduler.update(0.01f);
+                // c depends on a, which is skipped on even updates
+                CHECK(b.end < c.start);
+                if (a.start >= 0) {
+                    CHECK(b.end < a.start);
+                    CHECK(a.end < c.start);
+                }
+            }
+            CHECK_EQUAL(6, b.updates);
+            CHECK_EQUAL(3, a.updates);
+            CHECK_EQUAL(2, d.updates);
+            CHECK_EQUAL(6, f.updates);
+            // given the time elapsed since their previous update
+            CHECK_CLOSE(0.02f, a.dt, 0.0001f);
+            CHECK_CLOSE(0.01f, b.dt, 0.0001f);
+            CHECK_CLOSE(0.03f, d.dt, 0.0001f);
+
+            a.setPeriod(1, 0);
+            d.setPeriod(1, 0);
+        }
+        jobs.setWorkerCount(0);
+    }
+}
@@ -25,8 +25,21 @@
 #include <base/Log.h>
 
 #include <glm/glm.hpp>
+#include "base/FrameArena.h"
+#include "base/JobSystem.h"
+#include "systems/AnchorSystem.h"
+#include "systems/BackInTimeSystem.h"
+#include "systems/CameraSystem.h"
+#include "systems/MorphingSystem.h"
 #include "systems/RenderingSystem.h"
+#include "systems/RenderingSystem_Private.h"
+#include "systems/TransformationSystem.h"
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "tests_utils.h"
 
 TEST(save_restore_internalState)
 {
@@ -55,3 +68,375 @@ LOGW("RESTORE TEST ?");
         RenderingSystem::DestroyInstance();
 #endif
 }
+
+namespace {
+    struct PipelineSetup : public NeedsEntityManager {
+        PipelineSetup() : NeedsEntityManager() {
+            TransformationSystem::CreateInstance();
+            AnchorSystem::CreateInstance();
+            RenderingSystem::CreateInstance();
+            CameraSystem::CreateInstance();
+            BackInTimeSystem::CreateInstance();
+        }
+        ~PipelineSetup() {
+            uninit();
+            BackInTimeSystem::DestroyInstance();
+            CameraSystem::DestroyInstance();
+            RenderingSystem::DestroyInstance();
+            AnchorSystem::DestroyInstance();
+            TransformationSystem::DestroyInstance();
+        }
+    };
+}
+
+#if ! SAC_INGAME_EDITORS
+// in-game editors need a GL context
+TEST_FIXTURE(PipelineSetup, PipelinedFrameCarriesLastStepMotion) {
+    Entity camera = theEntityManager.CreateEntity(HASH("camera", 0x526b9e0c));
+    ADD_COMPONENT(camera, Transformation);
+    ADD_COMPONENT(camera, Camera);
+    TRANSFORM(camera)->size = glm::vec2(20, 12);
+    CAMERA(camera)->enable = true;
+
+    Entity e = theEntityManager.CreateEntity(HASH("sprite", 0xde9f4b5c));
+    ADD_COMPONENT(e, Transformation);
+    ADD_COMPONENT(e, Rendering);
+    ADD_COMPONENT(e, BackInTime);
+    TRANSFORM(e)->position = glm::vec2(1, 0);
+    TRANSFORM(e)->z = 0.5f;
+    RENDERING(e)->show = true;
+
+    // simulation step: BackInTime keeps the state before it
+    ComponentSystem::NextVersion();
+    theBackInTimeSystem.Update(1 / 30.0f);
+    TRANSFORM(e)->position = glm::vec2(2, 0.5f);
+    TRANSFORM(e)->rotation = 0.25f;
+
+    for (int pipelined = 0; pipelined < 2; pipelined++) {
+        theRenderingSystem.pipelined = pipelined;
+        theRenderingSystem.Update(1 / 30.0f);
+
+        const auto& frame =
+            theRenderingSystem.renderQueue[theRenderingSystem.handoff & QueueIndexMask];
+        // begin marker, sprite, end marker
+        CHECK_EQUAL(3, frame.count);
+        CHECK_CLOSE(1 / 30.0f, frame.step, 0.0001f);
+
+        const auto& c = frame.commands[1];
+        CHECK_CLOSE(2, c.position.x, 0.0001f);
+        CHECK_CLOSE(pipelined ? 1 : 0, c.positionDelta.x, 0.0001f);
+        CHECK_CLOSE(pipelined ? 0.5f : 0, c.positionDelta.y, 0.0001f);
+        CHECK_CLOSE(pipelined ? 0.25f : 0, c.rotationDelta, 0.0001f);
+        // camera did not move
+        CHECK_CLOSE(0, frame.commands[0].positionDelta.x, 0.0001f);
+        FrameArena::ResetAll();
+    }
+}
+
+TEST_FIXTURE(PipelineSetup, LatestFrameWinsHandoff) {
+    Entity camera = theEntityManager.CreateEntity(HASH("camera", 0x526b9e0c));
+    ADD_COMPONENT(camera, Transformation);
+    ADD_COMPONENT(camera, Camera);
+    CAMERA(camera)->enable = true;
+
+    // nothing produced yet
+    CHECK(!theRenderingSystem.acquireLatestFrame());
+    CHECK_EQUAL(0u, theRenderingSystem.reusedFrames.load());
+
+    // the first frame is never drawn: replaced by the second one
+    theRenderingSystem.Update(1 / 30.0f);
+    FrameArena::ResetAll();
+    const int first = theRenderingSystem.handoff & QueueIndexMask;
+    theRenderingSystem.Update(1 / 30.0f);
+    FrameArena::ResetAll();
+    const int second = theRenderingSystem.handoff & QueueIndexMask;
+    CHECK_EQUAL(1u, theRenderingSystem.droppedFrames.load());
+    CHECK(first != second);
+
+    CHECK(theRenderingSystem.acquireLatestFrame());
+    CHECK_EQUAL(second, theRenderingSystem.readQueue);
+    // the three queues stay distinct
+    CHECK(theRenderingSystem.writeQueue != theRenderingSystem.readQueue);
+    CHECK(theRenderingSystem.writeQueue != (theRenderingSystem.handoff & QueueIndexMask));
+
+    // no new frame: the same one is drawn again
+    CHECK(!theRenderingSystem.acquireLatestFrame());
+    CHECK_EQUAL(second, theRenderingSystem.readQueue);
+    CHECK_EQUAL(1u, theRenderingSystem.reusedFrames.load());
+}
+
+TEST_FIXTURE(PipelineSetup, LockStepDropsNoFrame) {
+    Entity camera = theEntityManager.CreateEntity(HASH("camera", 0x526b9e0c));
+    ADD_COMPONENT(camera, Transformation);
+    ADD_COMPONENT(camera, Camera);
+    CAMERA(camera)->enable = true;
+    theRenderingSystem.enableRendering();
+
+    // a slow render thread
+    std::atomic<bool> stop(false);
+    std::thread renderer([&stop] () {
+        while (!stop) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            theRenderingSystem.acquireLatestFrame();
+        }
+    });
+    for (int i=0; i<10; i++) {
+        theRenderingSystem.waitDrawingComplete();
+        theRenderingSystem.Update(1 / 30.0f);
+        FrameArena::ResetAll();
+    }
+    stop = true;
+    renderer.join();
+    CHECK_EQUAL(0u, theRenderingSystem.droppedFrames.load());
+
+    // the render thread isn't waited for once rendering is disabled
+    theRenderingSystem.disableRendering();
+    theRenderingSystem.Update(1 / 30.0f);
+    FrameArena::ResetAll();
+    theRenderingSystem.waitDrawingComplete();
+}
+
+TEST_FIXTURE(PipelineSetup, RenderThreadWaitsForNextFrame) {
+    Entity camera = theEntityManager.CreateEntity(HASH("camera", 0x526b9e0c));
+    ADD_COMPONENT(camera, Transformation);
+    ADD_COMPONENT(camera, Camera);
+    CAMERA(camera)->enable = true;
+    theRenderingSystem.enableRendering();
+
+    // nothing comes: gives up after the timeout
+    const auto start = std::chrono::steady_clock::now();
+    CHECK(!theRenderingSystem.acquireLatestFrame(0.02f));
+    CHECK(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(15));
+
+    // woken up by the frame being published
+    std::thread game([] () {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        theRenderingSystem.Update(1 / 30.0f);
+        FrameArena::ResetAll();
+    });
+    CHECK(theRenderingSystem.acquireLatestFrame(5));
+    game.join();
+    theRenderingSystem.disableRendering();
+}
+
+TEST_FIXTURE(PipelineSetup, ParallelFrameMatchesSequentialOne) {
+    Entity camera = theEntityManager.CreateEntity(HASH("camera", 0x526b9e0c));
+    ADD_COMPONENT(camera, Transformation);
+    ADD_COMPONENT(camera, Camera);
+    TRANSFORM(camera)->size = glm::vec2(100, 100);
+    CAMERA(camera)->enable = true;
+
+    // several jobs worth of sprites, with lots of equal sort keys
+    for (int i=0; i<1000; i++) {
+        Entity e = theEntityManager.CreateEntity(HASH("sprite", 0xde9f4b5c));
+        ADD_COMPONENT(e, Transformation);
+        ADD_COMPONENT(e, Rendering);
+        TRANSFORM(e)->position = glm::vec2((i % 90) - 45.0f, i * 0.09f - 45);
+        TRANSFORM(e)->z = 0.1f + (i % 7) * 0.1f;
+        RENDERING(e)->show = (i % 11) != 0;
+        if (i % 3)
+            RENDERING(e)->flags = RenderingFlags::NonOpaque;
+    }
+
+    std::vector<float> frames[2];
+    for (unsigned workers = 0; workers < 2; workers++) {
+        theJobSystem.setWorkerCount(workers * 3);
+        theRenderingSystem.Update(1 / 30.0f);
+
+        const auto& frame =
+            theRenderingSystem.renderQueue[theRenderingSystem.handoff & QueueIndexMask];
+        for (unsigned i=0; i<frame.count; i++) {
+            const auto& c = frame.commands[i];
+            // markers don't use position
+            if (c.texture == BeginFrameMarker || c.texture == EndFrameMarker)
+                continue;
+            frames[workers].push_back(c.position.x);
+            frames[workers].push_back(c.position.y);
+            frames[workers].push_back(c.z);
+        }
+        FrameArena::ResetAll();
+    }
+    theJobSystem.setWorkerCount(0);
+
+    // shown sprites
+    CHECK_EQUAL(909u * 3, frames[0].size());
+    CHECK(frames[0] == frames[1]);
+}
+
+TEST_FIXTURE(PipelineSetup, CullingGridFollowsMovedSprites) {
+    Entity camera = theEntityManager.CreateEntity(HASH("camera", 0x526b9e0c));
+    ADD_COMPONENT(camera, Transformation);
+    ADD_COMPONENT(camera, Camera);
+    TRANSFORM(camera)->size = glm::vec2(20, 12);
+    CAMERA(camera)->enable = true;
+
+    Entity sprites[2];
+    for (int i=0; i<2; i++) {
+        sprites[i] = theEntityManager.CreateEntity(HASH("sprite", 0xde9f4b5c));
+        ADD_COMPONENT(sprites[i], Transformation);
+        ADD_COMPONENT(sprites[i], Rendering);
+        TRANSFORM(sprites[i])->z = 0.5f;
+        RENDERING(sprites[i])->show = true;
+    }
+    TRANSFORM(sprites[1])->position = glm::vec2(500, 0);
+
+    ComponentSystem::NextVersion();
+    theRenderingSystem.Update(1 / 30.0f);
+    FrameArena::ResetAll();
+    // begin marker, sprite, end marker
+    CHECK_EQUAL(3, theRenderingSystem.renderQueue[theRenderingSystem.handoff & QueueIndexMask].count);
+    CHECK_EQUAL(1u, theRenderingSystem.cullingStats.visited);
+    CHECK_EQUAL(1u, theRenderingSystem.cullingStats.culled);
+
+    // moved in view
+    ComponentSystem::NextVersion();
+    TRANSFORM(sprites[1])->position = glm::vec2(2, 1);
+    theRenderingSystem.Update(1 / 30.0f);
+    FrameArena::ResetAll();
+    CHECK_EQUAL(4, theRenderingSystem.renderQueue[theRenderingSystem.handoff & QueueIndexMask].count);
+    CHECK_EQUAL(2u, theRenderingSystem.cullingStats.visited);
+    CHECK_EQUAL(0u, theRenderingSystem.cullingStats.culled);
+}
+TEST_FIXTURE(PipelineSetup, CullingGridFollowsDeletedAndNewSprites) {
+    Entity camera = theEntityManager.CreateEntity(HASH("camera", 0x526b9e0c));
+    ADD_COMPONENT(camera, Transformation);
+    ADD_COMPONENT(camera, Camera);
+    TRANSFORM(camera)->size = glm::vec2(20, 12);
+    CAMERA(camera)->enable = true;
+
+    Entity sprites[2];
+    for (int i=0; i<2; i++) {
+        sprites[i] = theEntityManager.CreateEntity(HASH("sprite", 0xde9f4b5c));
+        ADD_COMPONENT(sprites[i], Transformation);
+        ADD_COMPONENT(sprites[i], Rendering);
+        TRANSFORM(sprites[i])->position = glm::vec2(i, 0);
+        TRANSFORM(sprites[i])->z = 0.5f;
+        RENDERING(sprites[i])->show = true;
+    }
+    ComponentSystem::NextVersion();
+    theRenderingSystem.Update(1 / 30.0f);
+    FrameArena::ResetAll();
+    CHECK_EQUAL(2u, theRenderingSystem.cullingStats.visited);
+
+    // deleted sprite leaves the grid
+    ComponentSystem::NextVersion();
+    theEntityManager.DeleteEntity(sprites[1]);
+    theRenderingSystem.Update(1 / 30.0f);
+    FrameArena::ResetAll();
+    CHECK_EQUAL(1u, theRenderingSystem.cullingStats.visited);
+    CHECK_EQUAL(0u, theRenderingSystem.cullingStats.culled);
+
+    // a new sprite (reusing its index) with the same transform is inserted
+    ComponentSystem::NextVersion();
+    Entity e = theEntityManager.CreateEntity(HASH("sprite", 0xde9f4b5c));
+    ADD_COMPONENT(e, Transformation);
+    ADD_COMPONENT(e, Rendering);
+    TRANSFORM(e)->position = glm::vec2(1, 0);
+    TRANSFORM(e)->z = 0.5f;
+    RENDERING(e)->show = true;
+    theRenderingSystem.Update(1 / 30.0f);
+    FrameArena::ResetAll();
+    CHECK_EQUAL(4, theRenderingSystem.renderQueue[theRenderingSystem.handoff & QueueIndexMask].count);
+    CHECK_EQUAL(2u, theRenderingSystem.cullingStats.visited);
+
+    // cell size change rebuilds the grid
+    ComponentSystem::NextVersion();
+    theRenderingSystem.cullingCellSize = 3;
+    TRANSFORM(e)->position = glm::vec2(500, 0);
+    theRenderingSystem.Update(1 / 30.0f);
+    FrameArena::ResetAll();
+    CHECK_EQUAL(1u, theRenderingSystem.cullingStats.visited);
+    CHECK_EQUAL(1u, theRenderingSystem.cullingStats.culled);
+}
+#if !DISABLE_MORPHING_SYSTEM
+TEST_FIXTURE(PipelineSetup, CullingGridFollowsUnstampedWrites) {
+    MorphingSystem::CreateInstance();
+    Entity camera = theEntityManager.CreateEntity(HASH("camera", 0x526b9e0c));
+    ADD_COMPONENT(camera, Transformation);
+    ADD_COMPONENT(camera, Camera);
+    TRANSFORM(camera)->size = glm::vec2(20, 12);
+    CAMERA(camera)->enable = true;
+
+    Entity sprites[2];
+    for (int i=0; i<2; i++) {
+        sprites[i] = theEntityManager.CreateEntity(HASH("sprite", 0xde9f4b5c));
+        ADD_COMPONENT(sprites[i], Transformation);
+        ADD_COMPONENT(sprites[i], Rendering);
+        TRANSFORM(sprites[i])->position = glm::vec2(500, 0);
+        TRANSFORM(sprites[i])->z = 0.5f;
+        RENDERING(sprites[i])->show = true;
+    }
+    // sprites[0] is morphed in view, sprites[1] is moved through a pointer
+    // kept from a previous frame
+    Entity morph = theEntityManager.CreateEntity(HASH("morph", 0xeedfa8c2));
+    ADD_COMPONENT(morph, Morphing);
+    MORPHING(morph)->elements.push_back(new TypedMorphElement<glm::vec2>(
+        &TRANSFORM(sprites[0])->position, glm::vec2(500, 0), glm::vec2(1, 0)));
+    MORPHING(morph)->timing = 1;
+    glm::vec2* held = &TRANSFORM(sprites[1])->position;
+
+    ComponentSystem::NextVersion();
+    theRenderingSystem.Update(1 / 30.0f);
+    FrameArena::ResetAll();
+    // begin and end markers only
+    CHECK_EQUAL(2, theRenderingSystem.renderQueue[theRenderingSystem.handoff & QueueIndexMask].count);
+
+    ComponentSystem::NextVersion();
+    MORPHING(morph)->active = true;
+    theMorphingSystem.Update(0);
+    theMorphingSystem.Update(1);
+    *held = glm::vec2(-2, 1);
+    theRenderingSystem.Update(1 / 30.0f);
+    FrameArena::ResetAll();
+    CHECK_CLOSE(1.0f, TRANSFORM(sprites[0])->position.x, 0.001f);
+    CHECK_EQUAL(4, theRenderingSystem.renderQueue[theRenderingSystem.handoff & QueueIndexMask].count);
+    CHECK_EQUAL(2u, theRenderingSystem.cullingStats.visited);
+
+    theMorphingSystem.clear(MORPHING(morph));
+    theEntityManager.DeleteEntity(morph);
+    MorphingSystem::DestroyInstance();
+}
+#endif
+
+TEST_FIXTURE(PipelineSetup, CamerasAreBinnedInOnePass) {
+    Entity cameras[2];
+    for (int i=0; i<2; i++) {
+        cameras[i] = theEntityManager.CreateEntity(HASH("camera", 0x526b9e0c));
+        ADD_COMPONENT(cameras[i], Transformation);
+        ADD_COMPONENT(cameras[i], Camera);
+        TRANSFORM(cameras[i])->size = glm::vec2(20, 12);
+        TRANSFORM(cameras[i])->position = glm::vec2(500.0f * i, 0);
+        CAMERA(cameras[i])->enable = true;
+        CAMERA(cameras[i])->id = i;
+        CAMERA(cameras[i])->order = i;
+    }
+
+    // seen by both cameras, second camera only, near the second camera but
+    // only drawn by the first one
+    const glm::vec2 positions[] = { glm::vec2(0, 0), glm::vec2(500, 0), glm::vec2(500, 1) };
+    const int masks[] = { 0x3, 0x2, 0x1 };
+    for (int i=0; i<3; i++) {
+        Entity e = theEntityManager.CreateEntity(HASH("sprite", 0xde9f4b5c));
+        ADD_COMPONENT(e, Transformation);
+        ADD_COMPONENT(e, Rendering);
+        TRANSFORM(e)->position = positions[i];
+        TRANSFORM(e)->z = 0.5f;
+        RENDERING(e)->show = true;
+        RENDERING(e)->cameraBitMask = masks[i];
+    }
+
+    ComponentSystem::NextVersion();
+    theRenderingSystem.Update(1 / 30.0f);
+    FrameArena::ResetAll();
+    const auto& queue = theRenderingSystem.renderQueue[theRenderingSystem.handoff & QueueIndexMask];
+    // [begin marker, sprite] per camera, end marker
+    CHECK_EQUAL(5, queue.count);
+    CHECK_EQUAL(BeginFrameMarker, queue.commands[0].texture);
+    CHECK_CLOSE(0.0f, queue.commands[1].position.x, 0.001f);
+    CHECK_EQUAL(BeginFrameMarker, queue.commands[2].texture);
+    CHECK_CLOSE(500.0f, queue.commands[3].position.x, 0.001f);
+    // each camera only visited the sprites near it
+    CHECK_EQUAL(3u, theRenderingSystem.cullingStats.visited);
+    CHECK_EQUAL(3u, theRenderingSystem.cullingStats.culled);
+}
+#endif
@@ -0,0 +1,375 @@
+/*
+    This file is part of Soupe Au Caillou.
+
+    @author Soupe au Caillou - Jordane Pelloux-Prayer
+    @author Soupe au Caillou - Gautier Pelloux-Prayer
+    @author Soupe au Caillou - Pierre-Eric Pelloux-Prayer
+
+    Soupe Au Caillou is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3.
+
+    Soupe Au Caillou is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Soupe Au Caillou.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#include <UnitTest++.h>
+
+#include "systems/CameraSystem.h"
+#include "systems/TransformationSystem.h"
+#include "tests_utils.h"
+
+#include <algorithm>
+
+namespace {
+    struct CountedComponent {
+        CountedComponent() : name("default") { alive++; }
+        CountedComponent(const CountedComponent& c) : name(c.name) { alive++; }
+        CountedComponent& operator=(const CountedComponent& c) { name = c.name; return *this; }
+        ~CountedComponent() { alive--; }
+        std::string name;
+        static int alive;
+    };
+    int CountedComponent::alive = 0;
+
+    class CountedSystem : public ComponentSystemImpl<CountedComponent> {
+        public:
+        CountedSystem(const char* name, ComponentStorage::Enum storage)
+            : ComponentSystemImpl<CountedComponent>(Murmur::RuntimeHash(name), ComponentType::Complex, 8, storage) {}
+        void DoUpdate(float) override {}
+    };
+
+    struct VisitedComponent {
+        int visits;
+    };
+
+    class SlicedSystem : public ComponentSystemImpl<VisitedComponent> {
+        public:
+        SlicedSystem() : ComponentSystemImpl<VisitedComponent>(Murmur::RuntimeHash("SlicedSystem")), dt(0) {
+            enableTimeSlicing();
+        }
+        void DoUpdate(float pDt) override {
+            dt = pDt;
+            FOR_EACH_ENTITY_COMPONENT_SLICED(Visited, e, comp)
+                LOGF_IF(!e, "Invalid entity");
+                comp->visits++;
+            END_FOR_EACH()
+        }
+        float dt;
+    };
+
+    struct SoaComponent {
+        SoaComponent() : position(1.0f, 2.0f), id(0) {}
+        glm::vec2 position;
+        int id;
+    };
+
+    class SoaSystem : public ComponentSystemImpl<SoaComponent> {
+        public:
+        SoaSystem() : ComponentSystemImpl<SoaComponent>(Murmur::RuntimeHash("SoaSystem"), ComponentType::POD, 8, ComponentStorage::Soa) {
+            soaField(&SoaComponent::position);
+            soaField(&SoaComponent::id);
+        }
+        void DoUpdate(float) override {}
+    };
+
+    struct TestSetup : public NeedsEntityManager {
+        TestSetup() : NeedsEntityManager() {
+            // CameraSystem uses sparse storage, TransformationSystem direct
+            CameraSystem::CreateInstance();
+            TransformationSystem::CreateInstance();
+        }
+        ~TestSetup() {
+            uninit();
+            CameraSystem::DestroyInstance();
+            TransformationSystem::DestroyInstance();
+        }
+    };
+
+    TEST_FIXTURE(TestSetup, SparseStorageAddGet)
+    {
+        CHECK_EQUAL(ComponentStorage::Sparse, theCameraSystem.getStorage());
+        CHECK_EQUAL(ComponentStorage::Direct, theTransformationSystem.getStorage());
+
+        Entity e[] = { 90000, 5, 3000 };
+        for (int i=0; i<3; i++) {
+            theCameraSystem.Add(e[i]);
+            CAMERA(e[i])->order = i;
+        }
+        CHECK_EQUAL(3u, theCameraSystem.entityCount());
+        for (int i=0; i<3; i++) {
+            CHECK(theCameraSystem.hasComponent(e[i]));
+            CHECK_EQUAL(i, CAMERA(e[i])->order);
+        }
+        CHECK(!theCameraSystem.hasComponent(6));
+        CHECK(!theCameraSystem.hasComponent(200000));
+        CHECK(theCameraSystem.Get(6, false) == 0);
+    }
+
+    TEST_FIXTURE(TestSetup, SparseStorageDelete)
+    {
+        for (Entity e=1; e<=10; e++) {
+            theCameraSystem.Add(e * 100);
+            CAMERA(e * 100)->order = e;
+        }
+        theCameraSystem.Delete(300);
+        theCameraSystem.Delete(100);
+        theCameraSystem.Delete(1000);
+
+        CHECK_EQUAL(7u, theCameraSystem.entityCount());
+        CHECK(!theCameraSystem.hasComponent(100));
+        CHECK(!theCameraSystem.hasComponent(300));
+        CHECK(!theCameraSystem.hasComponent(1000));
+        for (Entity e: theCameraSystem.RetrieveAllEntityWithComponent()) {
+            CHECK_EQUAL((int)e / 100, CAMERA(e)->order);
+        }
+
+        theCameraSystem.Add(300);
+        CHECK_EQUAL(0, CAMERA(300)->order);
+        CHECK_EQUAL(8u, theCameraSystem.entityCount());
+    }
+
+    TEST_FIXTURE(TestSetup, SparseStorageIteration)
+    {
+        for (Entity e=1; e<=100; e++) {
+            theCameraSystem.Add(e * 7);
+            CAMERA(e * 7)->id = e * 7;
+        }
+        int count = 0;
+        theCameraSystem.forEachECDo([&count] (Entity e, CameraComponent* cc) -> void {
+            CHECK_EQUAL((int)e, cc->id);
+            count++;
+        });
+        CHECK_EQUAL(100, count);
+    }
+
+    TEST_FIXTURE(TestSetup, StaleHandleLookup)
+    {
+        const Entity previous = EntityHandle::make(7, 0);
+        const Entity current = EntityHandle::make(7, 1);
+        theCameraSystem.Add(current);
+        theTransformationSystem.Add(current);
+
+        CHECK(theCameraSystem.hasComponent(current));
+        CHECK(!theCameraSystem.hasComponent(previous));
+        CHECK(theCameraSystem.Get(previous, false) == 0);
+        CHECK(theTransformationSystem.hasComponent(current));
+        CHECK(!theTransformationSystem.hasComponent(previous));
+        CHECK(theTransformationSystem.Get(previous, false) == 0);
+    }
+
+    TEST_FIXTURE(TestSetup, DeleteMany)
+    {
+        Entity e[12];
+        for (int i=0; i<12; i++) {
+            e[i] = 12 - i;
+            theCameraSystem.Add(e[i]);
+            CAMERA(e[i])->order = e[i];
+            theTransformationSystem.Add(e[i]);
+            TRANSFORM(e[i])->z = e[i];
+        }
+        const Entity toDelete[] = { 3, 12, 1, 7 };
+        theCameraSystem.DeleteMany(toDelete, 4);
+        theTransformationSystem.DeleteMany(toDelete, 4);
+
+        CHECK_EQUAL(8u, theCameraSystem.entityCount());
+        CHECK_EQUAL(8u, theTransformationSystem.entityCount());
+        for (Entity d: toDelete) {
+            CHECK(!theCameraSystem.hasComponent(d));
+            CHECK(!theTransformationSystem.hasComponent(d));
+        }
+        const auto& remaining = theTransformationSystem.RetrieveAllEntityWithComponent();
+        CHECK(std::is_sorted(remaining.begin(), remaining.end()));
+        for (Entity r: remaining) {
+            CHECK_EQUAL((int)r, CAMERA(r)->order);
+            CHECK_EQUAL((float)r, TRANSFORM(r)->z);
+        }
+    }
+
+    TEST_FIXTURE(TestSetup, ViewJoin)
+    {
+        for (Entity e=1; e<=20; e++) {
+            theTransformationSystem.Add(e);
+            TRANSFORM(e)->z = e;
+            if (e % 3 == 0) {
+                theCameraSystem.Add(e);
+                CAMERA(e)->order = e;
+            }
+        }
+        // camera only
+        theCameraSystem.Add(30);
+
+        View<CameraComponent, TransformationComponent> view(theCameraSystem, theTransformationSystem);
+        CHECK_EQUAL(6u, view.size());
+        for (const auto& row: view) {
+            CHECK_EQUAL(0u, row.entity % 3);
+            CHECK_EQUAL((int)row.entity, row.get<0>()->order);
+            CHECK_EQUAL((float)row.entity, row.get<1>()->z);
+            CHECK(row.get<1>() == TRANSFORM(row.entity));
+        }
+    }
+
+    TEST_FIXTURE(TestSetup, MembershipVersion)
+    {
+        for (Entity e=1; e<=4; e++) {
+            theTransformationSystem.Add(e);
+            theCameraSystem.Add(e);
+        }
+        ComponentSystem::NextVersion();
+        const uint32_t v = ComponentSystem::CurrentVersion();
+        CHECK(theTransformationSystem.membershipVersion() < v);
+        CHECK(theCameraSystem.membershipVersion() < v);
+
+        // writing components doesn't change membership
+        TRANSFORM(2)->z = 0.1f;
+        theCameraSystem.Get(3)->order = 1;
+        CHECK(theTransformationSystem.membershipVersion() < v);
+        CHECK(theCameraSystem.membershipVersion() < v);
+
+        theCameraSystem.Delete(1);
+        CHECK(theCameraSystem.membershipVersion() >= v);
+        theTransformationSystem.Add(5);
+        CHECK(theTransformationSystem.membershipVersion() >= v);
+    }
+
+    TEST_FIXTURE(TestSetup, ComplexStorageIsStable)
+    {
+        ComponentStorage::Enum storages[] = { ComponentStorage::Direct, ComponentStorage::Sparse };
+        for (auto storage: storages) {
+            {
+                CountedSystem system("Counted", storage);
+                system.Add(3);
+                CountedComponent* c = system.Get(3);
+                c->name = "three";
+
+                std::vector<Entity> many;
+                for (Entity e=10; e<5000; e++) many.push_back(e);
+                system.AddMany(many.data(), many.size());
+                system.Add(4);
+                // growing didn't move nor copy existing components
+                CHECK(c == system.Get(3));
+                CHECK_EQUAL("three", c->name);
+                CHECK_EQUAL((int)many.size() + 2, CountedComponent::alive);
+
+                system.Get(4)->name = "four";
+                system.Delete(3);
+                CHECK_EQUAL("four", system.Get(4)->name);
+                system.DeleteMany(many.data(), 100);
+                system.DeleteMany(&many[100], 1);
+                CHECK_EQUAL((int)many.size() - 100, CountedComponent::alive);
+                CHECK_EQUAL("default", system.Get(200)->name);
+            }
+            // remaining components destroyed with their system
+            CHECK_EQUAL(0, CountedComponent::alive);
+        }
+    }
+
+    TEST_FIXTURE(TestSetup, SoaStorage)
+    {
+        SoaSystem system;
+        std::vector<Entity> many;
+        for (Entity e=1; e<=1000; e++) many.push_back(e * 3);
+        system.AddMany(many.data(), 500);
+        for (unsigned i=500; i<many.size(); i++) system.Add(many[i]);
+
+        SoaComponent c;
+        CHECK(system.read(3, c));
+        CHECK_EQUAL(2.0f, c.position.y);
+        CHECK(!system.read(4, c));
+
+        for (Entity e: many) {
+            c.position = glm::vec2(e, 0);
+            c.id = e;
+            system.write(e, c);
+        }
+        system.DeleteMany(many.data(), 600);
+        system.Delete(many.back());
+
+        // columns follow the entity list
+        const auto& entities = system.RetrieveAllEntityWithComponent();
+        CHECK_EQUAL(399u, entities.size());
+        const int* ids = system.column(&SoaComponent::id);
+        const glm::vec2* positions = system.column(&SoaComponent::position);
+        for (unsigned i=0; i<entities.size(); i++) {
+            CHECK_EQUAL((int)entities[i], ids[i]);
+            CHECK_EQUAL((float)entities[i], positions[i].x);
+        }
+        CHECK(static_cast<ComponentSystem&>(system).compact() > 0);
+        CHECK_EQUAL(many[700], (Entity)*system.readField(many[700], &SoaComponent::id));
+        CHECK(system.readField(many[0], &SoaComponent::id) == 0);
+
+        // generic (serialization, templates) accesses go through a copy
+        SoaComponent* copy = static_cast<SoaComponent*>(system.componentAsVoidPtr(many[800]));
+        CHECK_EQUAL((int)many[800], copy->id);
+        copy->id = -1;
+        system.storeComponent(many[800], copy);
+        CHECK_EQUAL(-1, *system.readField(many[800], &SoaComponent::id));
+        CHECK(system.componentAsVoidPtr(many[0]) == 0);
+    }
+
+    TEST_FIXTURE(TestSetup, ViewJoinDrivenBySecondSystem)
+    {
+        // transformations are the fewest: they drive the join, but rows keep
+        // the declared component order
+        for (Entity e=1; e<=20; e++) {
+            theCameraSystem.Add(e);
+            CAMERA(e)->order = e;
+            if (e % 4 == 0) {
+                theTransformationSystem.Add(e);
+                TRANSFORM(e)->z = e;
+            }
+        }
+        // transformation only
+        theTransformationSystem.Add(40);
+        TRANSFORM(40)->z = -1;
+
+        View<const CameraComponent, TransformationComponent> view(theCameraSystem, theTransformationSystem);
+        CHECK_EQUAL(5u, view.size());
+        for (const auto& row: view) {
+            CHECK_EQUAL(0u, row.entity % 4);
+            CHECK(row.get<0>() == CAMERA(row.entity));
+            CHECK(row.get<1>() == TRANSFORM(row.entity));
+            row.get<1>()->z = row.get<0>()->order * 2;
+        }
+        CHECK_EQUAL(40.0f, TRANSFORM(20)->z);
+        CHECK_EQUAL(-1.0f, TRANSFORM(40)->z);
+    }
+
+    TEST(TimeSlicedUpdate)
+    {
+        SlicedSystem system;
+        for (Entity e=1; e<=10; e++) {
+            system.Add(e);
+            system.Get(e)->visits = 0;
+        }
+
+        // every entity, every update
+        system.Update(0.01f);
+        CHECK_CLOSE(0.01f, system.dt, 0.0001f);
+        for (Entity e=1; e<=10; e++) {
+            CHECK_EQUAL(1, system.Get(e)->visits);
+        }
+
+        // 4 entities per update: a round takes 3 updates
+        ComponentSystem::UpdatePolicy policy;
+        policy.budget = 4;
+        system.setUpdatePolicy(policy);
+        for (int i=0; i<3; i++) {
+            system.Update(0.01f);
+            CHECK_CLOSE(0.03f, system.dt, 0.0001f);
+        }
+        for (Entity e=1; e<=10; e++) {
+            CHECK_EQUAL(2, system.Get(e)->visits);
+        }
+        system.Update(0.01f);
+        CHECK_EQUAL(3, system.Get(1)->visits);
+        CHECK_EQUAL(2, system.Get(5)->visits);
+    }
+}
@@ -0,0 +1,108 @@
+/*
+    This file is part of Soupe Au Caillou.
+
+    @author Soupe au Caillou - Jordane Pelloux-Prayer
+    @author Soupe au Caillou - Gautier Pelloux-Prayer
+    @author Soupe au Caillou - Pierre-Eric Pelloux-Prayer
+
+    Soupe Au Caillou is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3.
+
+    Soupe Au Caillou is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Soupe Au Caillou.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <UnitTest++.h>
+
+#include "util/LooseGrid.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+static AABB box(float x, float y, float halfW, float halfH) {
+    AABB b;
+    b.left = x - halfW;
+    b.right = x + halfW;
+    b.bottom = y - halfH;
+    b.top = y + halfH;
+    return b;
+}
+
+static bool intersect(const AABB& a, const AABB& b) {
+    return a.left <= b.right && b.left <= a.right && a.bottom <= b.top && b.bottom <= a.top;
+}
+
+TEST(LooseGridQueryReturnsEveryIntersectingItem) {
+    std::mt19937 generator(7);
+    std::uniform_real_distribution<float> position(-200, 200), size(0.1f, 12);
+    LooseGrid grid(4);
+    std::vector<AABB> items(2000);
+    for (unsigned i=0; i<items.size(); i++) {
+        items[i] = box(position(generator), position(generator), size(generator), size(generator));
+        grid.update(i, items[i]);
+    }
+    // move half of them
+    for (unsigned i=0; i<items.size(); i+=2) {
+        items[i] = box(position(generator), position(generator), size(generator), size(generator));
+        grid.update(i, items[i]);
+    }
+    CHECK_EQUAL(items.size(), grid.size());
+
+    const AABB areas[] = { box(0, 0, 10, 6), box(-150, 80, 30, 2), box(0, 0, 500, 500) };
+    for (const AABB& area: areas) {
+        std::vector<uint32_t> result;
+        grid.query(area, result);
+        std::sort(result.begin(), result.end());
+        CHECK(std::unique(result.begin(), result.end()) == result.end());
+        for (unsigned i=0; i<items.size(); i++) {
+            if (intersect(items[i], area)) {
+                CHECK(std::binary_search(result.begin(), result.end(), i));
+            }
+        }
+    }
+}
+
+TEST(LooseGridSkipsFarItems) {
+    LooseGrid grid(4);
+    grid.update(0, box(0, 0, 1, 1));
+    grid.update(1, box(100, 0, 1, 1));
+    // bigger than a cell: always returned
+    grid.update(2, box(-100, 0, 10, 1));
+
+    std::vector<uint32_t> result;
+    grid.query(box(2, 2, 2, 2), result);
+    std::sort(result.begin(), result.end());
+    CHECK_EQUAL(2u, result.size());
+    CHECK_EQUAL(0u, result[0]);
+    CHECK_EQUAL(2u, result[1]);
+}
+
+TEST(LooseGridRemove) {
+    LooseGrid grid(4);
+    for (uint32_t i=0; i<3; i++) {
+        grid.update(i, box(1, 1, 0.5f, 0.5f));
+    }
+    grid.remove(0);
+    grid.remove(0);
+    CHECK(!grid.contains(0));
+    CHECK(grid.contains(2));
+    CHECK_EQUAL(2u, grid.size());
+
+    std::vector<uint32_t> result;
+    grid.query(box(1, 1, 1, 1), result);
+    std::sort(result.begin(), result.end());
+    CHECK_EQUAL(2u, result.size());
+    CHECK_EQUAL(1u, result[0]);
+    CHECK_EQUAL(2u, result[1]);
+
+    grid.reset(8);
+    CHECK_EQUAL(0u, grid.size());
+    CHECK(!grid.contains(1));
+}
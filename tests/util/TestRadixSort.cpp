@@ -0,0 +1,78 @@
+/*
+    This file is part of Soupe Au Caillou.
+
+    @author Soupe au Caillou - Jordane Pelloux-Prayer
+    @author Soupe au Caillou - Gautier Pelloux-Prayer
+    @author Soupe au Caillou - Pierre-Eric Pelloux-Prayer
+
+    Soupe Au Caillou is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3.
+
+    Soupe Au Caillou is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Soupe Au Caillou.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <UnitTest++.h>
+
+#include "util/RadixSort.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+static bool lessKey(const SortKey& a, const SortKey& b) {
+    return a.key < b.key;
+}
+
+TEST(RadixSortMatchesStableSort) {
+    std::mt19937_64 generator(42);
+    std::vector<SortKey> keys(5000), tmp(keys.size());
+    for (unsigned i=0; i<keys.size(); i++) {
+        // few distinct values in low bits, to get lots of ties
+        keys[i].key = (generator() & 0xFFFF00000000ull) | (generator() % 7);
+        keys[i].index = i;
+    }
+    std::vector<SortKey> expected(keys);
+    std::stable_sort(expected.begin(), expected.end(), lessKey);
+
+    radixSort(&keys[0], &tmp[0], keys.size());
+
+    for (unsigned i=0; i<keys.size(); i++) {
+        CHECK_EQUAL(expected[i].key, keys[i].key);
+        CHECK_EQUAL(expected[i].index, keys[i].index);
+    }
+}
+
+TEST(RadixSortKeepsOrderOfEqualKeys) {
+    SortKey keys[6] = { {3, 0}, {1, 1}, {3, 2}, {1, 3}, {3, 4}, {0, 5} };
+    SortKey tmp[6];
+
+    radixSort(keys, tmp, 6);
+
+    const uint32_t expected[6] = { 5, 1, 3, 0, 2, 4 };
+    for (int i=0; i<6; i++) {
+        CHECK_EQUAL(expected[i], keys[i].index);
+    }
+}
+
+TEST(RadixSortDecreasingWithComplementedKeys) {
+    const uint64_t values[4] = { 0x10, 0xFF00000000000000ull, 0x10, 0x7 };
+    SortKey keys[4], tmp[4];
+    for (int i=0; i<4; i++) {
+        keys[i].key = ~values[i];
+        keys[i].index = i;
+    }
+
+    radixSort(keys, tmp, 4);
+
+    const uint32_t expected[4] = { 1, 0, 2, 3 };
+    for (int i=0; i<4; i++) {
+        CHECK_EQUAL(expected[i], keys[i].index);
+    }
+}
@@ -0,0 +1,73 @@
+/*
+    This file is part of Soupe Au Caillou.
+
+    @author Soupe au Caillou - Jordane Pelloux-Prayer
+    @author Soupe au Caillou - Gautier Pelloux-Prayer
+    @author Soupe au Caillou - Pierre-Eric Pelloux-Prayer
+
+    Soupe Au Caillou is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3.
+
+    Soupe Au Caillou is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Soupe Au Caillou.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+// Minimal benchmark harness used by sac_bench (see main.cpp).
+//
+//   BENCHMARK(entity_churn) {
+//       ... setup ...
+//       state.measure(opCount, [&] () { ... work ... });
+//       ... cleanup ...
+//   }
+//
+// measure() runs the work 'repeat' times and keeps the fastest run.
+namespace Bench {
+    struct Result {
+        std::string name;
+        unsigned ops;
+        double nsPerOp;
+        double allocationsPerOp;
+    };
+
+    class State {
+        public:
+        State(unsigned repeat) : repeat(repeat), ops(0), bestNs(0), allocations(0) {}
+
+        // 'work' performs 'opCount' operations
+        void measure(unsigned opCount, std::function<void()> work);
+
+        unsigned repeat;
+        unsigned ops;
+        double bestNs;
+        unsigned long allocations;
+    };
+
+    typedef void (*Function)(State&);
+
+    struct Registration {
+        Registration(const char* name, Function f);
+    };
+
+    struct Scenario {
+        const char* name;
+        Function function;
+    };
+    std::vector<Scenario>& scenarios();
+}
+
+#define BENCHMARK(name)                                                        \
+    static void bench_##name(Bench::State& state);                             \
+    static Bench::Registration registration_##name(#name, bench_##name);       \
+    static void bench_##name(Bench::State& state)
@@ -0,0 +1,495 @@
+/*
+    This file is part of Soupe Au Caillou.
+
+    @author Soupe au Caillou - Jordane Pelloux-Prayer
+    @author Soupe au Caillou - Gautier Pelloux-Prayer
+    @author Soupe au Caillou - Pierre-Eric Pelloux-Prayer
+
+    Soupe Au Caillou is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3.
+
+    Soupe Au Caillou is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Soupe Au Caillou.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Bench.h"
+
+#include "base/EntityManager.h"
+#include "base/FrameArena.h"
+#include "systems/AnchorSystem.h"
+#include "systems/BackInTimeSystem.h"
+#include "systems/CameraSystem.h"
+#include "systems/CollisionSystem.h"
+#include "systems/ParticuleSystem.h"
+#include "systems/PhysicsSystem.h"
+#include "systems/RenderingSystem.h"
+#include "systems/SpatialPartitionSystem.h"
+#include "systems/TextSystem.h"
+#include "systems/TransformationSystem.h"
+#include "util/Random.h"
+
+#include <map>
+#include <random>
+#include <sstream>
+
+// Each operation is one simulated frame unless stated otherwise
+static const float FrameDt = 1.0f / 60;
+static const unsigned WarmupFrames = 60;
+static const unsigned MeasuredFrames = 300;
+
+namespace {
+    // Headless world: entity manager and the systems used by the scenarios.
+    // Nothing here touches GL: textures are never loaded and the render
+    // queue is produced but never consumed.
+    struct World {
+        World() {
+            Random::Init(1);
+            EntityManager::CreateInstance();
+            TransformationSystem::CreateInstance();
+            AnchorSystem::CreateInstance();
+            RenderingSystem::CreateInstance();
+            CameraSystem::CreateInstance();
+            PhysicsSystem::CreateInstance();
+            BackInTimeSystem::CreateInstance();
+            SpatialPartitionSystem::CreateInstance();
+            CollisionSystem::CreateInstance();
+            ParticuleSystem::CreateInstance();
+            TextSystem::CreateInstance();
+        }
+        ~World() {
+            theEntityManager.deleteAllEntities();
+            TextSystem::DestroyInstance();
+            ParticuleSystem::DestroyInstance();
+            CollisionSystem::DestroyInstance();
+            SpatialPartitionSystem::DestroyInstance();
+            BackInTimeSystem::DestroyInstance();
+            PhysicsSystem::DestroyInstance();
+            CameraSystem::DestroyInstance();
+            RenderingSystem::DestroyInstance();
+            AnchorSystem::DestroyInstance();
+            TransformationSystem::DestroyInstance();
+            EntityManager::DestroyInstance();
+        }
+
+        // same sequence as Game::step, restricted to 'systems'
+        void frame(std::initializer_list<ComponentSystem*> systems) {
+            ComponentSystem::NextVersion();
+            for (auto* s: systems) {
+                s->Update(FrameDt);
+            }
+            theEntityManager.deferred.flush();
+            FrameArena::ResetAll();
+        }
+
+        Entity createCamera(const glm::vec2& size) {
+            Entity camera = theEntityManager.CreateEntity(HASH("bench/camera", 0xce692462));
+            ADD_COMPONENT(camera, Transformation);
+            ADD_COMPONENT(camera, Camera);
+            TRANSFORM(camera)->size = size;
+            CAMERA(camera)->enable = true;
+            return camera;
+        }
+    };
+}
+
+/* Entity create/delete churn: each frame deletes a quarter of the
+ * population and replaces it, exercising slot recycling and the
+ * per-system add/remove paths. One op = one entity created and deleted. */
+BENCHMARK(entity_churn) {
+    const unsigned Population = 10000;
+    const unsigned Churn = Population / 4;
+
+    World world;
+    std::mt19937 rng(42);
+    std::vector<Entity> alive(Population);
+
+    auto spawn = [] (Entity* out, unsigned count) {
+        theEntityManager.CreateEntities(count, out, HASH("bench/churn", 0x4bd0720));
+        theEntityManager.AddComponentToEntities(out, count,
+            { &theTransformationSystem, &theRenderingSystem });
+    };
+    spawn(alive.data(), Population);
+
+    auto churnFrame = [&] () {
+        std::shuffle(alive.begin(), alive.end(), rng);
+        for (unsigned i = 0; i < Churn; i++) {
+            theEntityManager.deferred.DeleteEntity(alive[i]);
+        }
+        theEntityManager.deferred.flush();
+        spawn(alive.data(), Churn);
+    };
+    for (unsigned i = 0; i < WarmupFrames; i++)
+        churnFrame();
+
+    state.measure(MeasuredFrames * Churn, [&] () {
+        for (unsigned i = 0; i < MeasuredFrames; i++)
+            churnFrame();
+    });
+}
+
+/* One-by-one entity API (no bulk calls, no deferred buffer): create the
+ * whole population, give each entity 2 components, then delete it in
+ * reverse order. One op = one entity created, added to and deleted. */
+BENCHMARK(entity_create_add_delete) {
+    const unsigned Population = 100000;
+
+    World world;
+    std::vector<Entity> entities(Population);
+
+    auto cycle = [&] () {
+        for (unsigned i = 0; i < Population; i++) {
+            entities[i] = theEntityManager.CreateEntity(HASH("bench/single", 0x662eb960));
+        }
+        for (unsigned i = 0; i < Population; i++) {
+            theEntityManager.AddComponent(entities[i], &theTransformationSystem);
+            theEntityManager.AddComponent(entities[i], &theRenderingSystem);
+        }
+        for (unsigned i = Population; i > 0; i--) {
+            theEntityManager.DeleteEntity(entities[i - 1]);
+        }
+    };
+    cycle();
+
+    state.measure(Population, cycle);
+}
+
+/* Join of 2 systems, the pattern of RenderingSystem (one pass per camera):
+ * 3 passes over 100000 entities having both a Camera and a Transformation,
+ * either looking each component up or through a View built once per frame.
+ * One op = one entity visited in one pass. */
+static void join(Bench::State& state, bool useView) {
+    const unsigned Count = 100000;
+    const unsigned Passes = 3;
+
+    World world;
+    std::vector<Entity> entities(Count);
+    theEntityManager.CreateEntities(Count, entities.data(), HASH("bench/join", 0xa488c0a5));
+    theEntityManager.AddComponentToEntities(entities.data(), Count,
+        { &theTransformationSystem, &theCameraSystem });
+    for (unsigned i = 0; i < Count; i++) {
+        CAMERA(entities[i])->order = i;
+    }
+
+    auto frame = [&] () {
+        if (useView) {
+            View<const CameraComponent, TransformationComponent> view(theCameraSystem, theTransformationSystem);
+            for (unsigned pass = 0; pass < Passes; pass++) {
+                for (const auto& row: view) {
+                    row.get<1>()->z = row.get<0>()->order;
+                }
+            }
+        } else {
+            for (unsigned pass = 0; pass < Passes; pass++) {
+                for (Entity e: theCameraSystem.RetrieveAllEntityWithComponent()) {
+                    TRANSFORM(e)->z = CAMERA(e)->order;
+                }
+            }
+        }
+        FrameArena::ResetAll();
+    };
+    frame();
+
+    state.measure(Count * Passes, frame);
+}
+
+BENCHMARK(join_get_100000) { join(state, false); }
+BENCHMARK(join_view_100000) { join(state, true); }
+
+namespace {
+    // 48 bytes, like most transform-ish POD components
+    struct MoverComponent {
+        MoverComponent() : position(0.0f), velocity(1.0f), size(1.0f), anchor(0.0f)
+            , rotation(0), z(0), opacity(1), lifetime(0) {}
+        glm::vec2 position, velocity, size, anchor;
+        float rotation, z, opacity, lifetime;
+    };
+
+    class MoverSystem : public ComponentSystemImpl<MoverComponent> {
+        public:
+        MoverSystem(ComponentStorage::Enum storage)
+            : ComponentSystemImpl<MoverComponent>(HASH("bench/Mover", 0x14bf190d), ComponentType::POD, 8, storage) {
+            if (storage == ComponentStorage::Soa) {
+                soaField(&MoverComponent::position);
+                soaField(&MoverComponent::velocity);
+                soaField(&MoverComponent::size);
+                soaField(&MoverComponent::anchor);
+                soaField(&MoverComponent::rotation);
+                soaField(&MoverComponent::z);
+                soaField(&MoverComponent::opacity);
+                soaField(&MoverComponent::lifetime);
+            }
+        }
+
+        // touches 2 of the 8 fields
+        void DoUpdate(float dt) override {
+            if (storage == ComponentStorage::Soa) {
+                glm::vec2* position = column(&MoverComponent::position);
+                const glm::vec2* velocity = column(&MoverComponent::velocity);
+                for (uint32_t i = 0; i < entityWithComponent.size(); i++) {
+                    position[i] += velocity[i] * dt;
+                }
+            } else {
+                FOR_EACH_COMPONENT(Mover, mc)
+                    mc->position += mc->velocity * dt;
+                END_FOR_EACH()
+            }
+        }
+    };
+}
+
+/* Component layout: 50000 entities integrating their position, with the
+ * component stored as an array of structures (Sparse) or as columns (Soa).
+ * One op = one entity updated. */
+static void moverLayout(Bench::State& state, ComponentStorage::Enum storage) {
+    const unsigned Count = 50000;
+
+    World world;
+    MoverSystem movers(storage);
+    std::vector<Entity> entities(Count);
+    theEntityManager.CreateEntities(Count, entities.data(), HASH("bench/mover", 0xb0627d4f));
+    theEntityManager.AddComponentToEntities(entities.data(), Count, { &movers });
+    for (unsigned i = 0; i < WarmupFrames; i++)
+        world.frame({ &movers });
+
+    state.measure(MeasuredFrames * Count, [&] () {
+        for (unsigned i = 0; i < MeasuredFrames; i++)
+            world.frame({ &movers });
+    });
+    theEntityManager.deleteAllEntities();
+}
+
+BENCHMARK(layout_aos_50000) { moverLayout(state, ComponentStorage::Sparse); }
+BENCHMARK(layout_soa_50000) { moverLayout(state, ComponentStorage::Soa); }
+
+/* Particle emitters: one emitter with a 1s particle lifetime, so roughly
+ * 'rate' particles are alive at steady state. */
+static void particles(Bench::State& state, float rate) {
+    World world;
+    world.createCamera(glm::vec2(20, 12));
+
+    Entity emitter = theEntityManager.CreateEntity(HASH("bench/emitter", 0xef7b1457));
+    ADD_COMPONENT(emitter, Transformation);
+    ADD_COMPONENT(emitter, Particule);
+    TRANSFORM(emitter)->size = glm::vec2(10, 6);
+    ParticuleComponent* pc = PARTICULE(emitter);
+    pc->emissionRate = rate;
+    pc->duration = -1;
+    pc->lifetime = Interval<float>(0.9f, 1.1f);
+    pc->initialColor = pc->finalColor = Interval<Color>(Color(1, 1, 1, 1), Color(1, 1, 1, 1));
+    pc->initialSize = Interval<float>(0.1f, 0.2f);
+    pc->finalSize = Interval<float>(0.0f, 0.1f);
+    pc->forceDirection = Interval<float>(0, 6.28f);
+    pc->forceAmplitude = Interval<float>(5, 10);
+    pc->mass = 1;
+    pc->gravity = glm::vec2(0, -10);
+
+    auto systems = { (ComponentSystem*)&theParticuleSystem,
+        (ComponentSystem*)&thePhysicsSystem, (ComponentSystem*)&theRenderingSystem };
+    for (unsigned i = 0; i < WarmupFrames * 2; i++)
+        world.frame(systems);
+
+    state.measure(MeasuredFrames, [&] () {
+        for (unsigned i = 0; i < MeasuredFrames; i++)
+            world.frame(systems);
+    });
+}
+
+BENCHMARK(particles_50) { particles(state, 50); }
+BENCHMARK(particles_200) { particles(state, 200); }
+BENCHMARK(particles_1000) { particles(state, 1000); }
+BENCHMARK(particles_10000) { particles(state, 10000); }
+
+/* Collision: N movers crossing a 40x40 box, all colliding with each other.
+ * Movers keep their velocity (nothing bounces) and wrap around the box, so
+ * the density stays constant over the run. */
+static void collision(Bench::State& state, unsigned count) {
+    const float HalfBox = 20;
+    World world;
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> pos(-HalfBox, HalfBox), speed(-5, 5);
+
+    std::vector<Entity> movers(count);
+    theEntityManager.CreateEntities(count, movers.data(), HASH("bench/mover", 0xb0627d4f));
+    theEntityManager.AddComponentToEntities(movers.data(), count, {
+        &theTransformationSystem, &theBackInTimeSystem, &thePhysicsSystem,
+        &theSpatialPartitionSystem, &theCollisionSystem });
+    for (Entity e: movers) {
+        TRANSFORM(e)->position = glm::vec2(pos(rng), pos(rng));
+        TRANSFORM(e)->size = glm::vec2(0.3f);
+        PHYSICS(e)->mass = 1;
+        PHYSICS(e)->linearVelocity = glm::vec2(speed(rng), speed(rng));
+        COLLISION(e)->group = 1;
+        COLLISION(e)->collideWith = 1;
+    }
+
+    auto step = [&] () {
+        for (Entity e: movers) {
+            glm::vec2& p = TRANSFORM(e)->position;
+            if (p.x < -HalfBox) p.x += 2 * HalfBox;
+            else if (p.x > HalfBox) p.x -= 2 * HalfBox;
+            if (p.y < -HalfBox) p.y += 2 * HalfBox;
+            else if (p.y > HalfBox) p.y -= 2 * HalfBox;
+        }
+        world.frame({ &thePhysicsSystem, &theSpatialPartitionSystem,
+            &theCollisionSystem, &theBackInTimeSystem });
+    };
+    for (unsigned i = 0; i < WarmupFrames; i++)
+        step();
+
+    state.measure(MeasuredFrames, [&] () {
+        for (unsigned i = 0; i < MeasuredFrames; i++)
+            step();
+    });
+}
+
+BENCHMARK(collision_100) { collision(state, 100); }
+BENCHMARK(collision_1000) { collision(state, 1000); }
+
+/* Text relayout: 200 labels whose content changes every frame */
+BENCHMARK(text_relayout) {
+    const unsigned Count = 200;
+    World world;
+    world.createCamera(glm::vec2(20, 12));
+
+    std::map<uint32_t, float> ratios;
+    for (uint32_t c = 0x20; c < 0x7f; c++)
+        ratios[c] = 0.5f;
+    theTextSystem.registerFont("bench", ratios);
+
+    std::vector<Entity> labels(Count);
+    theEntityManager.CreateEntities(Count, labels.data(), HASH("bench/label", 0x46a1651d));
+    theEntityManager.AddComponentToEntities(labels.data(), Count,
+        { &theTransformationSystem, &theTextSystem });
+    for (unsigned i = 0; i < Count; i++) {
+        TransformationComponent* tc = TRANSFORM(labels[i]);
+        tc->position = glm::vec2(-9 + (i % 10) * 2.0f, -5 + (i / 10) * 0.5f);
+        tc->size = glm::vec2(2, 0.5f);
+        TextComponent* text = TEXT(labels[i]);
+        text->fontName = HASH("bench", 0xf6964d72);
+        text->show = true;
+    }
+
+    unsigned frameIndex = 0;
+    auto relayout = [&] () {
+        for (unsigned i = 0; i < Count; i++) {
+            std::stringstream ss;
+            ss << "score " << (frameIndex * 7 + i);
+            TEXT(labels[i])->text = ss.str();
+        }
+        frameIndex++;
+        world.frame({ &theTextSystem, &theAnchorSystem });
+    };
+    for (unsigned i = 0; i < WarmupFrames; i++)
+        relayout();
+
+    state.measure(MeasuredFrames, [&] () {
+        for (unsigned i = 0; i < MeasuredFrames; i++)
+            relayout();
+    });
+}
+
+/* Render command generation: sprites scattered over twice the camera
+ * area, so about half of them are culled. Not available with in-game
+ * editors, whose hooks in RenderingSystem::DoUpdate need a GL context. */
+#if ! SAC_INGAME_EDITORS
+static void renderCommands(Bench::State& state, unsigned count) {
+    World world;
+    world.createCamera(glm::vec2(20, 12));
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> x(-14, 14), y(-8.5f, 8.5f), z(0.1f, 0.9f);
+
+    std::vector<Entity> sprites(count);
+    theEntityManager.CreateEntities(count, sprites.data(), HASH("bench/sprite", 0x9d36f837));
+    theEntityManager.AddComponentToEntities(sprites.data(), count,
+        { &theTransformationSystem, &theRenderingSystem });
+    for (unsigned i = 0; i < count; i++) {
+        TransformationComponent* tc = TRANSFORM(sprites[i]);
+        tc->position = glm::vec2(x(rng), y(rng));
+        tc->size = glm::vec2(0.5f);
+        tc->z = z(rng);
+        RenderingComponent* rc = RENDERING(sprites[i]);
+        rc->show = true;
+        if (i % 3 == 0)
+            rc->flags = RenderingFlags::NonOpaque;
+    }
+
+    for (unsigned i = 0; i < WarmupFrames; i++)
+        world.frame({ &theRenderingSystem });
+
+    state.measure(MeasuredFrames, [&] () {
+        for (unsigned i = 0; i < MeasuredFrames; i++)
+            world.frame({ &theRenderingSystem });
+    });
+}
+
+BENCHMARK(render_commands_1000) { renderCommands(state, 1000); }
+BENCHMARK(render_commands_10000) { renderCommands(state, 10000); }
+
+// static sprites along a strip 5 screens wide (x in [-50, 50])
+static void createSpriteStrip(unsigned count, int cameraBitMask) {
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> x(-50, 50), y(-6, 6), z(0.1f, 0.9f);
+
+    std::vector<Entity> sprites(count);
+    theEntityManager.CreateEntities(count, sprites.data(), HASH("bench/sprite", 0x9d36f837));
+    theEntityManager.AddComponentToEntities(sprites.data(), count,
+        { &theTransformationSystem, &theRenderingSystem });
+    for (unsigned i = 0; i < count; i++) {
+        TransformationComponent* tc = TRANSFORM(sprites[i]);
+        tc->position = glm::vec2(x(rng), y(rng));
+        tc->size = glm::vec2(0.5f);
+        tc->z = z(rng);
+        RENDERING(sprites[i])->show = true;
+        RENDERING(sprites[i])->cameraBitMask = cameraBitMask;
+    }
+}
+
+/* Scrolling level: 30000 static sprites along a strip 5 screens wide,
+ * about 80% of them off-screen, while the camera moves each frame. */
+BENCHMARK(render_scrolling_30000) {
+    World world;
+    Entity camera = world.createCamera(glm::vec2(20, 12));
+    createSpriteStrip(30000, 0x1);
+
+    unsigned frame = 0;
+    auto scroll = [&] () {
+        TRANSFORM(camera)->position.x = -40 + (frame++ % 80);
+        world.frame({ &theRenderingSystem });
+    };
+    for (unsigned i = 0; i < WarmupFrames; i++)
+        scroll();
+
+    state.measure(MeasuredFrames, [&] () {
+        for (unsigned i = 0; i < MeasuredFrames; i++)
+            scroll();
+    });
+}
+
+/* Same level seen by 3 split-screen views spread along the strip, plus a
+ * minimap showing all of it: one op = one frame producing the commands of
+ * the 4 cameras. */
+BENCHMARK(render_cameras_4_30000) {
+    World world;
+    for (int i = 0; i < 4; i++) {
+        Entity camera = world.createCamera(i < 3 ? glm::vec2(20, 12) : glm::vec2(100, 12));
+        TRANSFORM(camera)->position.x = i < 3 ? -30.0f + 30 * i : 0;
+        CAMERA(camera)->id = i;
+        CAMERA(camera)->order = i;
+    }
+    createSpriteStrip(30000, 0xf);
+
+    for (unsigned i = 0; i < WarmupFrames; i++)
+        world.frame({ &theRenderingSystem });
+
+    state.measure(MeasuredFrames, [&] () {
+        for (unsigned i = 0; i < MeasuredFrames; i++)
+            world.frame({ &theRenderingSystem });
+    });
+}
+#endif
@@ -0,0 +1,163 @@
+/*
+    This file is part of Soupe Au Caillou.
+
+    @author Soupe au Caillou - Jordane Pelloux-Prayer
+    @author Soupe au Caillou - Gautier Pelloux-Prayer
+    @author Soupe au Caillou - Pierre-Eric Pelloux-Prayer
+
+    Soupe Au Caillou is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3.
+
+    Soupe Au Caillou is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Soupe Au Caillou.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// sac_bench: headless benchmarks of the entity/component core.
+//
+// Usage: sac_bench [--list] [--filter <substring>] [--repeat N] [--workers N] [--output file.json]
+//
+// --workers sets the number of JobSystem worker threads (0 by default).
+//
+// Results are written as JSON (stdout by default), one entry per scenario:
+// time per operation and heap allocations per operation. The peak RSS is
+// reported once for the whole run, as the kernel only tracks it per process.
+
+#include "AllocationCounter.h"
+#include "Bench.h"
+
+#include "base/JobSystem.h"
+#include "base/Log.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sys/resource.h>
+
+namespace Bench {
+    std::vector<Scenario>& scenarios() {
+        static std::vector<Scenario> all;
+        return all;
+    }
+
+    Registration::Registration(const char* name, Function f) {
+        Scenario s = { name, f };
+        scenarios().push_back(s);
+    }
+
+    void State::measure(unsigned opCount, std::function<void()> work) {
+        for (unsigned r = 0; r < repeat; r++) {
+            const unsigned long a = AllocationCounter::count();
+            const auto start = std::chrono::steady_clock::now();
+            work();
+            const auto end = std::chrono::steady_clock::now();
+            const double ns =
+                std::chrono::duration<double, std::nano>(end - start).count();
+            if (r == 0 || ns < bestNs) {
+                bestNs = ns;
+                allocations = AllocationCounter::count() - a;
+            }
+        }
+        ops = opCount;
+    }
+}
+
+static long peakRssKb() {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return -1;
+#if SAC_DARWIN
+    // bytes on OS X
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+}
+
+static void writeJson(std::ostream& out, const std::vector<Bench::Result>& results) {
+    out << "{\n  \"peak_rss_kb\": " << peakRssKb() << ",\n  \"benchmarks\": [";
+    for (unsigned i = 0; i < results.size(); i++) {
+        const Bench::Result& r = results[i];
+        out << (i ? ",\n" : "\n")
+            << "    {\"name\": \"" << r.name << "\", \"ops\": " << r.ops
+            << ", \"ns_per_op\": " << r.nsPerOp
+            << ", \"allocations_per_op\": " << r.allocationsPerOp << "}";
+    }
+    out << "\n  ]\n}\n";
+}
+
+int main(int argc, char** argv) {
+    const char* filter = 0;
+    const char* output = 0;
+    unsigned repeat = 5;
+    unsigned workers = 0;
+    bool list = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--list")) {
+            list = true;
+        } else if (!strcmp(argv[i], "--filter") && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (!strcmp(argv[i], "--repeat") && i + 1 < argc) {
+            repeat = std::max(1, atoi(argv[++i]));
+        } else if (!strcmp(argv[i], "--workers") && i + 1 < argc) {
+            workers = std::max(0, atoi(argv[++i]));
+        } else if (!strcmp(argv[i], "--output") && i + 1 < argc) {
+            output = argv[++i];
+        } else {
+            std::cerr << "Usage: " << argv[0]
+                << " [--list] [--filter <substring>] [--repeat N] [--workers N] [--output file.json]"
+                << std::endl;
+            return 1;
+        }
+    }
+
+#if SAC_ENABLE_LOG
+    // scenarios deliberately hit warning paths (dead entities, missing assets...)
+    logLevel = LogVerbosity::FATAL;
+#endif
+    theJobSystem.setWorkerCount(workers);
+
+    std::vector<Bench::Result> results;
+    for (const Bench::Scenario& s : Bench::scenarios()) {
+        if (filter && !strstr(s.name, filter))
+            continue;
+        if (list) {
+            std::cout << s.name << std::endl;
+            continue;
+        }
+        std::cerr << "Running " << s.name << "..." << std::endl;
+
+        Bench::State state(repeat);
+        s.function(state);
+
+        Bench::Result r;
+        r.name = s.name;
+        r.ops = state.ops;
+        r.nsPerOp = state.ops ? state.bestNs / state.ops : 0;
+        r.allocationsPerOp = state.ops ? (double)state.allocations / state.ops : 0;
+        results.push_back(r);
+    }
+    if (list)
+        return 0;
+
+    if (output) {
+        std::ofstream out(output);
+        if (!out) {
+            std::cerr << "Unable to open '" << output << "'" << std::endl;
+            return 1;
+        }
+        writeJson(out, results);
+    } else {
+        writeJson(std::cout, results);
+    }
+    return 0;
+}
@@ -0,0 +1,113 @@
+/*
+    This file is part of Soupe Au Caillou.
+
+    @author Soupe au Caillou - Jordane Pelloux-Prayer
+    @author Soupe au Caillou - Gautier Pelloux-Prayer
+    @author Soupe au Caillou - Pierre-Eric Pelloux-Prayer
+
+    Soupe Au Caillou is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3.
+
+    Soupe Au Caillou is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Soupe Au Caillou.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "LooseGrid.h"
+
+#include <cmath>
+
+const uint64_t LooseGrid::LargeItems;
+const uint64_t LooseGrid::InvalidCell;
+
+LooseGrid::LooseGrid(float size) : count(0) {
+    reset(size);
+}
+
+void LooseGrid::reset(float size) {
+    cellSize = size;
+    invCellSize = 1.0f / size;
+    cells.clear();
+    large.clear();
+    slots.clear();
+    count = 0;
+}
+
+uint64_t LooseGrid::cellOf(const AABB& bounds) const {
+    if (bounds.right - bounds.left > cellSize || bounds.top - bounds.bottom > cellSize)
+        return LargeItems;
+    return cellKey(
+        (int32_t)std::floor((bounds.left + bounds.right) * 0.5f * invCellSize),
+        (int32_t)std::floor((bounds.bottom + bounds.top) * 0.5f * invCellSize));
+}
+
+std::vector<uint32_t>& LooseGrid::itemsOf(uint64_t cell) {
+    return (cell == LargeItems) ? large : cells[cell];
+}
+
+void LooseGrid::update(uint32_t id, const AABB& bounds) {
+    const uint64_t cell = cellOf(bounds);
+    if (id < slots.size() && slots[id].cell == cell)
+        return;
+
+    remove(id);
+    if (id >= slots.size())
+        slots.resize(id + 1);
+
+    std::vector<uint32_t>& items = itemsOf(cell);
+    slots[id].cell = cell;
+    slots[id].position = items.size();
+    items.push_back(id);
+    count++;
+}
+
+void LooseGrid::remove(uint32_t id) {
+    if (!contains(id))
+        return;
+
+    Slot& slot = slots[id];
+    std::vector<uint32_t>& items = itemsOf(slot.cell);
+    // last item takes the removed one's place
+    const uint32_t moved = items.back();
+    items[slot.position] = moved;
+    slots[moved].position = slot.position;
+    items.pop_back();
+    // empty cells are kept: items often come back to the same ones
+
+    slot.cell = InvalidCell;
+    count--;
+}
+
+void LooseGrid::query(const AABB& area, std::vector<uint32_t>& out) const {
+    out.insert(out.end(), large.begin(), large.end());
+
+    // items may stick out of their cell by half a cell
+    const float margin = cellSize * 0.5f;
+    const int32_t minX = (int32_t)std::floor((area.left - margin) * invCellSize);
+    const int32_t maxX = (int32_t)std::floor((area.right + margin) * invCellSize);
+    const int32_t minY = (int32_t)std::floor((area.bottom - margin) * invCellSize);
+    const int32_t maxY = (int32_t)std::floor((area.top + margin) * invCellSize);
+
+    if ((uint64_t)(maxX - minX + 1) * (maxY - minY + 1) > cells.size()) {
+        // area bigger than the populated part of the grid
+        for (const auto& c: cells) {
+            const int32_t x = (int32_t)(c.first >> 32);
+            const int32_t y = (int32_t)(uint32_t)c.first;
+            if (x >= minX && x <= maxX && y >= minY && y <= maxY)
+                out.insert(out.end(), c.second.begin(), c.second.end());
+        }
+        return;
+    }
+    for (int32_t y = minY; y <= maxY; y++) {
+        for (int32_t x = minX; x <= maxX; x++) {
+            auto it = cells.find(cellKey(x, y));
+            if (it != cells.end())
+                out.insert(out.end(), it->second.begin(), it->second.end());
+        }
+    }
+}
@@ -0,0 +1,79 @@
+/*
+    This file is part of Soupe Au Caillou.
+
+    @author Soupe au Caillou - Jordane Pelloux-Prayer
+    @author Soupe au Caillou - Gautier Pelloux-Prayer
+    @author Soupe au Caillou - Pierre-Eric Pelloux-Prayer
+
+    Soupe Au Caillou is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3.
+
+    Soupe Au Caillou is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Soupe Au Caillou.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "util/IntersectionUtil.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Uniform grid of bounding boxes, for "what may be in this area" queries.
+// Items are stored in the cell holding the center of their bounds, so a
+// query only has to look half a cell around its area; items bigger than a
+// cell are kept aside and always returned. Cells are allocated on demand,
+// so the covered area is unbounded.
+//
+// Ids are small integers (e.g. entity indices), each one in the grid at
+// most once.
+class LooseGrid {
+    public:
+        LooseGrid(float cellSize = 8);
+
+        // Empties the grid and changes its cell size
+        void reset(float cellSize);
+        float getCellSize() const { return cellSize; }
+
+        // Inserts 'id', or moves it if it's already in the grid
+        void update(uint32_t id, const AABB& bounds);
+        void remove(uint32_t id);
+        bool contains(uint32_t id) const {
+            return id < slots.size() && slots[id].cell != InvalidCell;
+        }
+        size_t size() const { return count; }
+
+        // Appends the ids whose bounds may intersect 'area' (and a few
+        // which don't: callers still need to test them)
+        void query(const AABB& area, std::vector<uint32_t>& out) const;
+
+    private:
+        static const uint64_t LargeItems = ~0ull;
+        static const uint64_t InvalidCell = ~0ull - 1;
+
+        uint64_t cellOf(const AABB& bounds) const;
+        static uint64_t cellKey(int32_t x, int32_t y) {
+            return ((uint64_t)(uint32_t)x << 32) | (uint32_t)y;
+        }
+        std::vector<uint32_t>& itemsOf(uint64_t cell);
+
+        float cellSize, invCellSize;
+        std::unordered_map<uint64_t, std::vector<uint32_t> > cells;
+        std::vector<uint32_t> large;
+
+        // where each id is stored
+        struct Slot {
+            Slot() : cell(InvalidCell), position(0) {}
+            uint64_t cell;
+            uint32_t position;
+        };
+        std::vector<Slot> slots;
+        size_t count;
+};
@@ -0,0 +1,73 @@
+/*
+    This file is part of Soupe Au Caillou.
+
+    @author Soupe au Caillou - Jordane Pelloux-Prayer
+    @author Soupe au Caillou - Gautier Pelloux-Prayer
+    @author Soupe au Caillou - Pierre-Eric Pelloux-Prayer
+
+    Soupe Au Caillou is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3.
+
+    Soupe Au Caillou is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Soupe Au Caillou.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "RadixSort.h"
+#include <cstring>
+#include <utility>
+
+void radixSort(SortKey* keys, SortKey* tmp, unsigned count) {
+    if (count <= 64) {
+        // histograms cost more than an insertion sort (stable too)
+        for (unsigned i=1; i<count; i++) {
+            const SortKey k = keys[i];
+            unsigned j = i;
+            for (; j > 0 && keys[j - 1].key > k.key; j--) {
+                keys[j] = keys[j - 1];
+            }
+            keys[j] = k;
+        }
+        return;
+    }
+
+    // all digit histograms in a single pass
+    uint32_t histograms[8][256];
+    memset(histograms, 0, sizeof(histograms));
+    for (unsigned i=0; i<count; i++) {
+        uint64_t k = keys[i].key;
+        for (int d=0; d<8; d++) {
+            histograms[d][k & 0xFF]++;
+            k >>= 8;
+        }
+    }
+
+    SortKey* src = keys;
+    SortKey* dst = tmp;
+    for (int d=0; d<8; d++) {
+        uint32_t* h = histograms[d];
+        const unsigned shift = d * 8;
+        if (h[(src[0].key >> shift) & 0xFF] == count)
+            continue;
+
+        // counts -> start offsets
+        uint32_t offset = 0;
+        for (int b=0; b<256; b++) {
+            const uint32_t c = h[b];
+            h[b] = offset;
+            offset += c;
+        }
+        for (unsigned i=0; i<count; i++) {
+            dst[h[(src[i].key >> shift) & 0xFF]++] = src[i];
+        }
+        std::swap(src, dst);
+    }
+
+    if (src != keys)
+        memcpy(keys, src, count * sizeof(SortKey));
+}
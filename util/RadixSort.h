@@ -0,0 +1,36 @@
+/*
+    This file is part of Soupe Au Caillou.
+
+    @author Soupe au Caillou - Jordane Pelloux-Prayer
+    @author Soupe au Caillou - Gautier Pelloux-Prayer
+    @author Soupe au Caillou - Pierre-Eric Pelloux-Prayer
+
+    Soupe Au Caillou is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3.
+
+    Soupe Au Caillou is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Soupe Au Caillou.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstdint>
+
+// Sorting item: a key and the index of what it was computed from, so big
+// structs are moved once (after the sort) instead of at every swap.
+struct SortKey {
+    uint64_t key;
+    uint32_t index;
+};
+
+// Stable LSD radix sort of 'keys' by increasing key, 8 bits per pass.
+// 'tmp' must hold 'count' items; the result ends up in 'keys'. Passes where
+// all keys share the same digit are skipped, and small arrays use an
+// insertion sort.
+void radixSort(SortKey* keys, SortKey* tmp, unsigned count);
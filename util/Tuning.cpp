@@ -7,6 +7,7 @@ void Tuning::load(const char* assetName) {
     if (fb.size) {
 		dfp.load(fb, assetName);
 		registerNewAsset(assetName);
+		changeCount++;
 		delete[] fb.data;
     }
 }
@@ -15,6 +16,7 @@ void Tuning::reload(const char* assetName) {
     FileBuffer fb = assetAPI->loadAsset(assetName);
     if (fb.size) {
 		dfp.load(fb, assetName);
+		changeCount++;
 		delete[] fb.data;
     }
 }
@@ -35,6 +37,7 @@ void Tuning::setF(hash_t h, float f) {
 		INV_HASH(h),
 		&f);
 	typeHints[h] = TuningType::Float;
+	changeCount++;
 }
 
 int Tuning::i(hash_t h) {
@@ -53,4 +56,17 @@ void Tuning::setI(hash_t h, int f) {
 		INV_HASH(h),
 		&f);
 	typeHints[h] = TuningType::Int;
-}
\ No newline at end of file
+	changeCount++;
+}
+
+float Tuning::f(hash_t section, hash_t h, float def) const {
+	float result = def;
+	dfp.get<float>(section, h, &result, 1, false);
+	return result;
+}
+
+int Tuning::i(hash_t section, hash_t h, int def) const {
+	int result = def;
+	dfp.get<int>(section, h, &result, 1, false);
+	return result;
+}
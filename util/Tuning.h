@@ -20,6 +20,7 @@ private:
 public:
 	static Tuning* getSingleton() { return instance; }
 public:
+	Tuning() : assetAPI(0), changeCount(0) {}
 
 	void init(AssetAPI* a) { assetAPI = a; instance = this;}
 	void load(const char* assetName);
@@ -32,6 +33,13 @@ public:
 	void setF(hash_t h, float f);
 	void setI(hash_t h, int f);
 
+	// value of 'h' in [section] (e.g: settings of a system), or 'def'
+	float f(hash_t section, hash_t h, float def) const;
+	int i(hash_t section, hash_t h, int def) const;
+
+	// changes each time values may have changed (load, reload, set)
+	unsigned version() const { return changeCount; }
+
 	const char* asset2FilePrefix() const { return ""; }
     const char* asset2FileSuffix() const { return ""; }
 
@@ -41,6 +49,7 @@ private:
 	AssetAPI* assetAPI;
 	DataFileParser dfp;
 	std::map<hash_t, TuningType::Enum> typeHints;
+	unsigned changeCount;
 };
 
 #define theTuning (*(Tuning::getSingleton()))
\ No newline at end of file